@@ -0,0 +1,25 @@
+#ifndef ANALYTICS_H
+#define ANALYTICS_H
+
+#include <vector>
+#include "network_index.h"
+
+// Пара трамваев и количество их общих остановок
+struct TramOverlap {
+    int tramA;
+    int tramB;
+    int shared;
+};
+
+// Попарные пересечения маршрутов как разреженное произведение индекса трамвай->остановки
+// на индекс остановка->трамваи. Трамваи делятся между потоками, в результат попадают только
+// пары с не менее чем minShared общими остановками, по убыванию количества.
+std::vector<TramOverlap> tramOverlaps(const NetworkIndex& network, int minShared);
+
+// Центральность по посредничеству (алгоритм Брандеса) для неориентированного графа остановок,
+// ребра которого - соседние остановки маршрутов. Источники делятся между потоками, у каждого
+// потока свой аккумулятор. Если samples > 0 и меньше числа остановок, берется равномерная
+// выборка источников, а результат масштабируется.
+std::vector<double> betweennessCentrality(const NetworkIndex& network, int samples);
+
+#endif // ANALYTICS_H
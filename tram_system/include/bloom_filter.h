@@ -0,0 +1,44 @@
+#ifndef BLOOM_FILTER_H
+#define BLOOM_FILTER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Счетчики поиска по имени через фильтр
+struct LookupStats {
+    uint64_t lookups = 0; // Всего поисков
+    uint64_t rejected = 0; // Отсечено фильтром без обращения к словарю
+    uint64_t falsePositives = 0; // Фильтр пропустил, но имени в словаре не оказалось
+};
+
+// Блочный фильтр Блума: все биты одного ключа лежат в одном 64-байтовом блоке,
+// поэтому проверка стоит одного-двух обращений к кэшу
+class BloomFilter {
+public:
+    static constexpr int BITS_PER_KEY = 10; // ~1% ложных срабатываний
+    static constexpr int HASHES = 6; // Битов на ключ внутри блока
+
+private:
+    struct alignas(64) Block {
+        uint64_t words[8] = {};
+    };
+
+    std::vector<Block> blocks;
+    size_t capacity = 0; // На сколько ключей рассчитан текущий размер
+    size_t count = 0; // Сколько ключей добавлено
+
+    static uint64_t hash(const std::string& key);
+
+public:
+    void reset(size_t expectedKeys); // Очищает фильтр и задает размер под expectedKeys ключей
+    void insert(const std::string& key);
+    bool mayContain(const std::string& key) const; // false - ключа точно нет
+    bool full() const; // Добавлено больше ключей, чем рассчитано, пора пересобрать
+    size_t size() const; // Количество ключей
+    size_t bits() const; // Размер в битах
+    double estimatedFalsePositiveRate() const;
+};
+
+#endif // BLOOM_FILTER_H
@@ -0,0 +1,82 @@
+#ifndef CHANGE_FEED_H
+#define CHANGE_FEED_H
+
+#include <atomic>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Кольцевой буфер для одного писателя и одного читателя без блокировок.
+// Писатель публикует слот release-записью tail, читатель освобождает его release-записью head.
+template <typename T, size_t Capacity>
+class SpscRing {
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+private:
+    T slots[Capacity];
+    alignas(64) std::atomic<size_t> head{0}; // Следующий слот для чтения
+    alignas(64) std::atomic<size_t> tail{0}; // Следующий слот для записи
+
+public:
+    bool push(const T& value) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == Capacity) {
+            return false;
+        }
+        slots[t & (Capacity - 1)] = value;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T& value) {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        value = std::move(slots[h & (Capacity - 1)]);
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+};
+
+// Событие изменения сети: трамвай начал или перестал обслуживать остановку
+struct ChangeEvent {
+    std::string tram;
+    std::string stop;
+    bool newStop = false; // Остановка появилась в системе вместе с этим трамваем
+    bool removed = false; // Трамвай удален или его новый маршрут больше не проходит через остановку
+};
+
+// Рассылка изменений подписчикам. У каждого подписчика свой кольцевой буфер, поэтому
+// createTram не ждет читателей; при переполнении события отбрасываются и учитываются.
+// Регистрация и отмена подписок выполняются в потоке, который вызывает publish.
+class ChangeFeed {
+public:
+    static constexpr size_t QUEUE_CAPACITY = 1024; // Размер буфера подписчика
+
+private:
+    struct Subscriber {
+        std::string stop; // Остановка фильтра (пусто для подписки на все)
+        SpscRing<ChangeEvent, QUEUE_CAPACITY> queue;
+        std::atomic<size_t> dropped{0}; // Событий потеряно из-за переполнения
+    };
+
+    std::map<int, std::unique_ptr<Subscriber>> subscribers;
+    std::map<std::string, std::vector<Subscriber*>> byStop; // Подписки на конкретные остановки
+    std::vector<Subscriber*> all; // Подписки на все изменения
+    int nextId = 1;
+
+    void deliver(Subscriber& subscriber, const ChangeEvent& event);
+
+public:
+    int subscribeStop(const std::string& stop); // Возвращает номер подписки
+    int subscribeAll();
+    bool unsubscribe(int id);
+    void publish(const ChangeEvent& event);
+    bool poll(int id, std::vector<ChangeEvent>& events, size_t& dropped); // Забирает накопленные события, false для неизвестной подписки
+    bool empty() const; // Нет ни одного подписчика
+};
+
+#endif // CHANGE_FEED_H
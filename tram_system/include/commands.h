@@ -4,9 +4,39 @@
 
 enum class CommandType {
     CREATE_TRAM,
+    REMOVE_TRAM,
+    CHANGE_TRAM,
     TRAMS_IN_STOP,
     STOPS_IN_TRAM,
     TRAMS,
+    CONNECTED,
+    COMPONENTS,
+    SET_COORDS,
+    LOAD_COORDS,
+    NEAREST_STOPS,
+    STOPS_IN_RADIUS,
+    FOOTPATHS,
+    REACHABLE,
+    REACHABLE_BATCH,
+    ANALYZE,
+    SUBSCRIBE,
+    UNSUBSCRIBE,
+    EVENTS,
+    FORMAT,
+    USE,
+    DROP,
+    TENANTS,
+    POSITION,
+    INGEST,
+    NEXT_TRAMS,
+    STATS,
+    DIFF,
+    ROUTES,
+    ROUTE,
+    PRECOMPUTE,
+    LOAD_PATTERNS,
+    MEMORY,
+    TRACE,
     UNKNOWN
 };
 
@@ -15,4 +45,6 @@ struct Command {
     std::vector<std::string> args; // Аргументы команды (например, номер трамвая, название остановки и т.д.)
 };
 
-Command parseCommand(const std::string& input);
\ No newline at end of file
+Command parseCommand(const std::string& input);
+bool parseNumber(const std::string& text, double& value); // Разбор числового аргумента, false при ошибке
+bool parseNumber(const std::string& text, int& value);
\ No newline at end of file
@@ -0,0 +1,21 @@
+#ifndef DISJOINT_SET_H
+#define DISJOINT_SET_H
+
+#include <vector>
+
+// Система непересекающихся множеств (union-find) для учета связности остановок
+class DisjointSet {
+private:
+    mutable std::vector<int> parent; // Родитель элемента (mutable для сжатия путей в find)
+    std::vector<int> size; // Размер множества, хранится в корне
+    int components = 0; // Количество множеств
+
+public:
+    int add(); // Добавляет новый элемент в отдельное множество и возвращает его номер
+    int find(int x) const; // Возвращает корень множества элемента
+    bool unite(int a, int b); // Объединяет множества, возвращает false, если они уже совпадали
+    bool connected(int a, int b) const; // Проверяет, лежат ли элементы в одном множестве
+    int count() const; // Количество множеств
+};
+
+#endif // DISJOINT_SET_H
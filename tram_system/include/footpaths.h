@@ -0,0 +1,32 @@
+#ifndef FOOTPATHS_H
+#define FOOTPATHS_H
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+#include "spatial_index.h"
+
+// Пешая пересадка до соседней остановки
+struct Footpath {
+    int stop; // ID остановки назначения
+    int seconds; // Время пешком в секундах
+};
+
+// Таблица пеших пересадок: пересадки каждой остановки лежат подряд в одном массиве
+class FootpathTable {
+private:
+    std::vector<int> start; // Начало пересадок остановки в paths, размер stopCount+1
+    std::vector<Footpath> paths; // Пересадки, упорядоченные по остановке отправления и времени
+
+public:
+    static constexpr double MAX_WALK_METERS = 400.0; // Максимальная длина пешей пересадки
+    static constexpr double WALK_SPEED = 1.25; // Скорость пешехода в м/с
+
+    // lats/lons/hasCoords индексируются ID остановки; соседи ищутся по сетке параллельно
+    void build(const SpatialIndex& index, const std::vector<double>& lats, const std::vector<double>& lons,
+               const std::vector<char>& hasCoords);
+    std::pair<const Footpath*, const Footpath*> from(int stopId) const; // Пересадки от остановки [begin, end)
+    size_t size() const; // Общее количество пересадок
+};
+
+#endif // FOOTPATHS_H
@@ -0,0 +1,43 @@
+#ifndef MEMORY_TRACKER_H
+#define MEMORY_TRACKER_H
+
+#include <cstddef>
+
+// Структуры, к которым относятся выделения памяти
+enum class MemoryCategory {
+    OTHER, // Все, что выделено вне областей учета
+    NAMES, // Имена трамваев и остановок (ключи словарей и поля объектов)
+    ROUTES, // Маршруты трамваев и пул общих маршрутов
+    STOP_TRAMS, // Списки трамваев в остановках
+    MAP_NODES, // Узлы словарей трамваев и остановок
+    INDEXES, // ID остановок, связность, фильтры, снимки сети, сетка, пересадки и графы
+    COUNT
+};
+
+// Живые байты и блоки категории и общее число выделений с начала работы
+struct MemoryUsage {
+    size_t bytes = 0;
+    size_t blocks = 0;
+    size_t allocations = 0;
+};
+
+// Учет включается сборкой с -DTRAM_TRACK_MEMORY=ON: тогда глобальные operator new/delete
+// записывают размер и категорию в заголовок блока. Счетчики общие для всего процесса.
+bool memoryTrackingEnabled();
+MemoryUsage getMemoryUsage(MemoryCategory category);
+const char* getMemoryCategoryName(MemoryCategory category);
+MemoryCategory currentMemoryCategory(); // Категория, к которой сейчас относятся выделения этого потока
+
+// Пока объект жив, выделения текущего потока относятся к category
+class MemoryScope {
+private:
+    MemoryCategory previous;
+
+public:
+    explicit MemoryScope(MemoryCategory category);
+    ~MemoryScope();
+    MemoryScope(const MemoryScope&) = delete;
+    MemoryScope& operator=(const MemoryScope&) = delete;
+};
+
+#endif // MEMORY_TRACKER_H
@@ -0,0 +1,28 @@
+#ifndef NETWORK_DIFF_H
+#define NETWORK_DIFF_H
+
+#include <string>
+#include <utility>
+#include <vector>
+
+// Набор маршрутов из файла: строки "<tram> <stop1> <stop2> ..." (допускается префикс CREATE_TRAM)
+struct RouteSet {
+    std::vector<std::pair<std::string, std::vector<std::string>>> trams; // По возрастанию имени, без повторов
+};
+
+// Исключение std::invalid_argument, если файл не открывается или маршрут не подходит для CREATE_TRAM
+RouteSet loadRouteSet(const std::string& path);
+
+// Минимальный список изменений, переводящий сеть A в сеть B
+struct NetworkDiff {
+    std::vector<std::pair<std::string, std::vector<std::string>>> addedTrams;
+    std::vector<std::string> removedTrams;
+    std::vector<std::pair<std::string, std::vector<std::string>>> changedTrams; // Новый маршрут
+    std::vector<std::string> addedStops; // Остановки, которые обслуживаются только в B
+    std::vector<std::string> lostService; // Остановки, которые в B не обслуживает ни один трамвай
+};
+
+// Маршруты сравниваются по хэшам последовательностей, которые считаются параллельно
+NetworkDiff diffNetworks(const RouteSet& before, const RouteSet& after);
+
+#endif // NETWORK_DIFF_H
@@ -0,0 +1,21 @@
+#ifndef NETWORK_INDEX_H
+#define NETWORK_INDEX_H
+
+#include <string>
+#include <vector>
+
+// Компактный снимок сети на числовых ID для алгоритмов обхода и аналитики.
+// Маршруты и обратный индекс хранятся в CSR-виде: массив начал и плоский массив значений.
+struct NetworkIndex {
+    std::vector<std::string> tramNames; // Имя трамвая по его ID (в порядке TramSystem::trams)
+    std::vector<int> tramStopStart; // Начало маршрута трамвая в tramStops, размер tramCount+1
+    std::vector<int> tramStops; // ID остановок маршрутов подряд
+    std::vector<int> stopTramStart; // Начало списка трамваев остановки в stopTrams, размер stopCount+1
+    std::vector<int> stopTrams; // ID трамваев, проходящих через остановки, по возрастанию
+
+    int tramCount() const;
+    int stopCount() const;
+    void buildStopTrams(int stopCount); // Строит обратный индекс по уже заполненным маршрутам
+};
+
+#endif // NETWORK_INDEX_H
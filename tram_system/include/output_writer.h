@@ -0,0 +1,73 @@
+#ifndef OUTPUT_WRITER_H
+#define OUTPUT_WRITER_H
+
+#include <cstdint>
+#include <initializer_list>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+enum class OutputFormat {
+    TEXT, // Строки для человека, как раньше
+    JSON, // Один JSON-массив на ответ
+    BINARY // Кадр с 4-байтовой длиной, поля с типовыми тегами
+};
+
+bool parseOutputFormat(const std::string& text, OutputFormat& format); // "text" / "json" / "binary" без учета регистра
+
+// Потоковый писатель ответов. Имена пишутся из string_view прямо в переиспользуемый буфер,
+// ответ целиком уходит в поток одним вызовом write в endResponse.
+//
+// Ответ состоит из сообщений, ошибок и записей. Запись - это тип, строковые поля (заголовок),
+// затем числа и списки. В текстовом формате запись выглядит как "<тип> <поля>: <значения>".
+//
+// Бинарный формат (little-endian): u32 длина кадра, затем элементы:
+//   'M' str - сообщение, 'E' str - ошибка,
+//   'R' str(тип) ... 'Z' - запись с полями 'S' str(ключ) str, 'N' str(ключ) f64, 'L' str(ключ) u32 n, n * str,
+// где str - u32 длина и байты.
+class OutputWriter {
+private:
+    std::ostream& out;
+    OutputFormat format;
+    std::string buffer; // Ответ накапливается здесь, память переиспользуется между ответами
+    bool firstElement = true; // JSON: нужна ли запятая перед следующим элементом ответа
+    bool headerHasContent = false; // TEXT: в заголовке записи уже что-то выведено
+    bool headerClosed = false; // TEXT: заголовок закрыт двоеточием, идут значения
+    bool bodyHasContent = false; // TEXT: в записи уже есть значения
+    bool firstKey = true; // JSON: первое поле записи
+    bool firstItem = true; // JSON: первый элемент списка
+    size_t listCountPos = 0; // BINARY: где записать количество элементов списка
+    uint32_t listCount = 0;
+
+    void appendU32(uint32_t value);
+    void putU32(size_t pos, uint32_t value);
+    void appendString(std::string_view value); // BINARY: длина и байты
+    void appendJsonEscaped(std::string_view value); // Без кавычек
+    void appendJsonString(std::string_view value);
+    void appendJsonKey(std::string_view key);
+    void beginElement(); // JSON: разделитель элементов ответа
+    void closeHeader(); // TEXT: переход от заголовка к значениям
+    void text(char kind, std::string_view prefix, std::initializer_list<std::string_view> parts);
+
+public:
+    OutputWriter(std::ostream& out, OutputFormat format);
+
+    OutputFormat getFormat() const;
+    void setFormat(OutputFormat format);
+
+    void beginResponse();
+    void endResponse(); // Закрывает ответ и выводит буфер
+
+    void message(std::initializer_list<std::string_view> parts); // Сообщение из склеенных частей
+    void error(std::initializer_list<std::string_view> parts); // Ошибка из склеенных частей
+
+    void beginRecord(std::string_view type);
+    void field(std::string_view key, std::string_view value); // Строковое поле заголовка
+    void number(std::string_view key, double value, int precision = 0, std::string_view unit = {}); // NaN и бесконечность в JSON - null
+    void beginList(std::string_view key);
+    void item(std::string_view value);
+    void endList();
+    void endRecord();
+};
+
+#endif // OUTPUT_WRITER_H
@@ -0,0 +1,14 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <cstddef>
+#include <functional>
+
+// Количество рабочих потоков для параллельных расчетов (не меньше 1)
+unsigned workerCount();
+
+// Делит диапазон [0, count) на непрерывные куски и обрабатывает их в отдельных потоках.
+// body(begin, end, worker) получает номер потока для работы с его собственным аккумулятором.
+void parallelFor(size_t count, const std::function<void(size_t, size_t, unsigned)>& body);
+
+#endif // PARALLEL_H
@@ -0,0 +1,16 @@
+#ifndef REACHABILITY_H
+#define REACHABILITY_H
+
+#include <vector>
+#include "network_index.h"
+#include "footpaths.h"
+
+// Остановки, достижимые из origin не более чем на k трамваях (с пешими пересадками между ними).
+// Обход идет по уровням: каждый уровень садится на все еще не использованные трамваи фронта.
+std::vector<int> reachableStops(const NetworkIndex& network, const FootpathTable& footpaths, int origin, int k);
+
+// Пакетный вариант: количество достижимых остановок для каждого источника, источники делятся между потоками
+std::vector<int> reachableCounts(const NetworkIndex& network, const FootpathTable& footpaths,
+                                 const std::vector<int>& origins, int k);
+
+#endif // REACHABILITY_H
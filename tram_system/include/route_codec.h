@@ -0,0 +1,12 @@
+#ifndef ROUTE_CODEC_H
+#define ROUTE_CODEC_H
+
+#include <cstdint>
+#include <vector>
+
+// Компактное представление маршрута: первая остановка и разности соседних ID
+// кодируются zigzag-varint, так что типичный перегон занимает 1-2 байта
+std::vector<uint8_t> encodeRoute(const std::vector<int>& stopIds);
+std::vector<int> decodeRoute(const std::vector<uint8_t>& data);
+
+#endif // ROUTE_CODEC_H
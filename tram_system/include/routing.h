@@ -0,0 +1,82 @@
+#ifndef ROUTING_H
+#define ROUTING_H
+
+#include <string>
+#include <vector>
+#include "network_index.h"
+#include "footpaths.h"
+
+// Участок пути на одном трамвае (tram >= 0) или пешком (tram == -1), индексы - позиции в StopPath::stops
+struct PathLeg {
+    int tram;
+    size_t from;
+    size_t to;
+};
+
+// Вид ребра графа состояний
+enum class EdgeKind {
+    BOARD, // Остановка -> трамвай у соседней по его маршруту остановки (посадка и первый перегон)
+    RIDE, // Трамвай у остановки -> тот же трамвай у соседней
+    ALIGHT, // Трамвай -> остановка, на которой он стоит
+    WALK // Остановка -> остановка пешком
+};
+
+// Ребро графа состояний; вид нужен, чтобы участки пути совпадали с тем, за что посчитано время
+struct GraphEdge {
+    int to;
+    int seconds;
+    EdgeKind kind;
+};
+
+// Граф состояний пассажира в CSR-виде для поиска маршрутов. Вершины [0, stops) - на остановке
+// после поездки, [stops, 2 * stops) - на остановке до первой посадки, дальше по вершине на каждую
+// позицию NetworkIndex::tramStops - в трамвае, приехавшем к этой остановке. Поэтому участок пути
+// всегда знает свой трамвай, а посадка после поездки (пересадка) стоит еще transferSeconds.
+struct StopGraph {
+    int stops = 0;
+    std::vector<int> start; // Начало ребер вершины в edges, размер nodeCount+1
+    std::vector<GraphEdge> edges;
+    std::vector<int> rideStop; // Остановка и трамвай вершин поездки по позиции в tramStops
+    std::vector<int> rideTram;
+
+    // Перегоны всех трамваев в обе стороны по rideSeconds и пешие пересадки; из параллельных ребер остается самое быстрое
+    void build(const NetworkIndex& network, const FootpathTable& footpaths, int rideSeconds, int transferSeconds);
+    int stopCount() const;
+    int nodeCount() const;
+    int freshNode(int stop) const; // Вершина отправления: на остановке, еще без поездок
+    bool isStopNode(int node) const;
+    int stopOf(int node) const;
+    const GraphEdge* findEdge(int from, int to) const; // nullptr, если ребра нет
+};
+
+// Путь по вершинам графа и его проекция на остановки и участки
+struct StopPath {
+    std::vector<int> nodes;
+    std::vector<int> stops;
+    std::vector<PathLeg> legs;
+    int seconds = 0;
+};
+
+// Участок найденного маршрута по именам, tram пусто для пешего участка
+struct JourneyLeg {
+    std::string tram;
+    std::string from;
+    std::string to;
+};
+
+// Маршрут между остановками для вывода
+struct Journey {
+    int seconds = 0;
+    std::vector<std::string> stops;
+    std::vector<JourneyLeg> legs;
+};
+
+// k кратчайших путей без циклов (алгоритм Йена). Буферы поиска переиспользуются между
+// ответвлениями, а для длинных путей ответвления одной итерации считаются параллельно.
+std::vector<StopPath> kShortestPaths(const StopGraph& graph, int from, int to, int k);
+
+// Дерево кратчайших путей от вершины from: prev[v] - предыдущая вершина (-1 для from и недостижимых),
+// order - вершины в порядке удаления из очереди, родитель всегда раньше потомка
+void shortestPathTree(const StopGraph& graph, int from, std::vector<int>& prev, std::vector<int>& order);
+
+#endif // ROUTING_H
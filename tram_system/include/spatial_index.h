@@ -0,0 +1,30 @@
+#ifndef SPATIAL_INDEX_H
+#define SPATIAL_INDEX_H
+
+#include <utility>
+#include <vector>
+
+// Равномерная сетка по остановкам, строится целиком за один проход (сортировка подсчетом).
+// Координаты проецируются на плоскость (равнопромежуточная проекция), расстояния - в метрах.
+class SpatialIndex {
+private:
+    double originLat = 0.0; // Широта, относительно которой считается масштаб долготы
+    double cosOriginLat = 1.0;
+    double minX = 0.0, minY = 0.0; // Левый нижний угол сетки в метрах
+    double cellSize = 1.0; // Сторона ячейки в метрах
+    int cols = 0, rows = 0;
+    std::vector<int> cellStart; // Начало точек ячейки в ids/xs/ys, размер cols*rows+1
+    std::vector<int> ids; // ID остановок, упорядоченные по ячейкам
+    std::vector<double> xs, ys; // Спроецированные координаты в том же порядке
+
+    void project(double lat, double lon, double& x, double& y) const;
+    int cellOf(double x, double y, int& cx, int& cy) const;
+
+public:
+    void build(const std::vector<int>& stopIds, const std::vector<double>& lats, const std::vector<double>& lons);
+    bool empty() const;
+    std::vector<std::pair<int, double>> nearest(double lat, double lon, int k) const; // k ближайших: (ID, метры)
+    std::vector<std::pair<int, double>> withinRadius(double lat, double lon, double radius) const; // Все в радиусе, по возрастанию расстояния
+};
+
+#endif // SPATIAL_INDEX_H
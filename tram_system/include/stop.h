@@ -7,16 +7,26 @@
 class Stop {
 private:
     std::string name; // Название остановки
+    int id = -1; // Числовой ID остановки внутри TramSystem
     std::vector<std::string> trams; // Список трамваев, которые останавливаются на этой остановке
+    bool hasCoords = false; // Заданы ли координаты остановки
+    double lat = 0.0, lon = 0.0; // Широта и долгота в градусах
 
 public:
     Stop() = default; // Добавленный конструктор по умолчанию
-    Stop(const std::string& name); // Конструктор, который инициализирует остановку с заданным именем
+    Stop(const std::string& name, int id); // Конструктор, который инициализирует остановку с заданным именем и ID
     
     const std::string& getName() const; // Метод для получения имени остановки
+    int getId() const; // Метод для получения ID остановки
     const std::vector<std::string>& getTrams() const; // Метод для получения списка трамваев, которые останавливаются на этой остановке
     
+    bool hasCoordinates() const; // Метод для проверки, заданы ли координаты
+    double getLat() const; // Метод для получения широты
+    double getLon() const; // Метод для получения долготы
+    
     void addTram(const std::string& tram); // Метод для добавления трамвая в список трамваев на этой остановке
+    void removeTram(const std::string& tram); // Метод для удаления трамвая из списка (всех его повторов)
+    void setCoordinates(double lat, double lon); // Метод для задания координат остановки
 };
 
-#endif // STOP_H
\ No newline at end of file
+#endif // STOP_H
@@ -0,0 +1,61 @@
+#ifndef TENANTS_H
+#define TENANTS_H
+
+#include <cstddef>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "tram_system.h"
+
+// Статистика одного города
+struct TenantStats {
+    std::string name;
+    size_t trams = 0;
+    size_t stops = 0;
+    size_t memoryBytes = 0; // Оценка памяти структур TramSystem
+    uint64_t queries = 0; // Количество выполненных команд
+};
+
+// Несколько независимых TramSystem в одном процессе, по одной на город
+class Tenants {
+private:
+    struct Tenant {
+        std::unique_ptr<TramSystem> system;
+        uint64_t queries = 0;
+    };
+
+    std::map<std::string, Tenant> tenants;
+    std::string currentName;
+    bool compactRoutes;
+
+    // Удаленные города освобождает один фоновый поток; деструктор дожидается, пока он освободит все
+    std::thread reclaimer;
+    std::mutex reclaimMutex;
+    std::condition_variable reclaimReady;
+    std::vector<std::unique_ptr<TramSystem>> reclaimQueue;
+    bool stopping = false;
+
+    void reclaim(); // Цикл фонового потока
+
+public:
+    static constexpr const char* DEFAULT_TENANT = "default";
+
+    explicit Tenants(bool compactRoutes);
+    ~Tenants();
+    Tenants(const Tenants&) = delete;
+    Tenants& operator=(const Tenants&) = delete;
+
+    TramSystem& current(); // Текущий город
+    const std::string& getCurrentName() const;
+    void countQuery(); // Учитывает команду текущего города (для USE - уже выбранного)
+    bool use(const std::string& name); // Переключается на город, создавая его при необходимости; true если создан
+    void drop(const std::string& name); // Удаляет город целиком; исключение для текущего или неизвестного
+    std::vector<TenantStats> getStats() const;
+};
+
+#endif // TENANTS_H
@@ -0,0 +1,46 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Трассировка обработки команд в формате Chrome trace-event (chrome://tracing, Perfetto).
+// Каждый поток пишет события в свой буфер без блокировок; выключенный span стоит одну
+// атомарную загрузку флага.
+
+extern std::atomic<bool> traceEnabledFlag;
+
+void setTraceEnabled(bool enabled); // Включение начинает новую запись и очищает буферы
+uint64_t traceNow(); // Микросекунды от запуска программы
+void recordTraceEvent(const char* name, std::string_view detail, uint64_t start, uint64_t end);
+size_t writeTrace(const std::string& path, size_t& dropped); // Возвращает количество событий, исключение при ошибке записи
+
+// Интервал от создания до уничтожения объекта; name должен жить до конца программы (литерал),
+// detail - до конца интервала, в событие попадают его первые символы
+class TraceSpan {
+private:
+    const char* name;
+    std::string_view detail;
+    uint64_t start = 0;
+    bool active;
+
+public:
+    explicit TraceSpan(const char* name, std::string_view detail = {})
+        : name(name), detail(detail), active(traceEnabledFlag.load(std::memory_order_relaxed)) {
+        if (active) start = traceNow();
+    }
+    ~TraceSpan() {
+        end();
+    }
+    void end() { // Досрочное завершение интервала
+        if (active) recordTraceEvent(name, detail, start, traceNow());
+        active = false;
+    }
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+};
+
+#endif // TRACE_H
@@ -1,21 +1,29 @@
 #ifndef TRAM_H
 #define TRAM_H
 
+#include <cstdint>
+#include <memory>
 #include <string>
 #include <vector>
 
 class Tram {
 private:
     std::string name; // Имя трамвая
-    std::vector<std::string> stops; // Список остановок, на которых останавливается трамвай
+    std::shared_ptr<const std::vector<std::string>> stops; // Список остановок, на которых останавливается трамвай (общий для одинаковых маршрутов)
+    std::shared_ptr<const std::vector<uint8_t>> encodedStops; // Компактный режим: delta/varint-поток ID остановок (см. route_codec.h)
 
 public:
     Tram(const std::string& name, const std::vector<std::string>& stops); // Конструктор класса Tram, принимающий имя трамвая и список остановок
+    Tram(const std::string& name, std::shared_ptr<const std::vector<std::string>> stops); // Конструктор, разделяющий уже сохраненный маршрут
+    Tram(const std::string& name, std::shared_ptr<const std::vector<uint8_t>> encodedStops); // Конструктор для компактного режима, принимающий закодированный маршрут
     
     const std::string& getName() const; // Метод для получения имени трамвая
-    const std::vector<std::string>& getStops() const; // Метод для получения списка остановок трамвая
+    const std::vector<std::string>& getStops() const; // Метод для получения списка остановок трамвая (в компактном режиме пуст)
+    const std::vector<uint8_t>& getEncodedStops() const; // Метод для получения закодированного маршрута
+    bool isCompact() const; // Хранится ли маршрут в компактном виде
+    const void* getRouteStorage() const; // Адрес хранилища маршрута, совпадает у трамваев с общим маршрутом
     
-    bool passesThrough(const std::string& stop) const; // Метод для проверки, проходит ли трамвай через указанную остановку
+    bool passesThrough(const std::string& stop) const; // Метод для проверки, проходит ли трамвай через указанную остановку (обычный режим)
 };
 
-#endif // TRAM_H
\ No newline at end of file
+#endif // TRAM_H
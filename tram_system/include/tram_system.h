@@ -2,22 +2,122 @@
 #define TRAM_SYSTEM_H
 
 #include <map>
+#include <memory>
+#include <unordered_map>
+#include <tuple>
 #include <string>
 #include <vector>
 #include <stdexcept>
 #include "tram.h"
 #include "stop.h"
+#include "disjoint_set.h"
+#include "spatial_index.h"
+#include "footpaths.h"
+#include "network_index.h"
+#include "change_feed.h"
+#include "vehicle_positions.h"
+#include "bloom_filter.h"
+#include "routing.h"
+#include "transfer_patterns.h"
 
 class TramSystem {
 private:
     std::map<std::string, Tram> trams; // Словарь, где ключ - имя трамвая, значение - объект трамвая
     std::map<std::string, Stop> stops; // Словарь, где ключ - имя остановки, значение - объект остановки
+    std::vector<const Stop*> stopById; // Остановки по их ID (узлы std::map не перемещаются)
+    bool compactRoutes = false; // Хранить ли маршруты в виде delta/varint-потока ID
+    mutable DisjointSet connectivity; // Компоненты связности остановок, элементы - ID остановок
+    mutable bool connectivityDirty = false; // Трамваи удалялись после последнего пересчета компонент
+    mutable SpatialIndex spatialIndex; // Сетка по остановкам с координатами
+    mutable bool spatialIndexDirty = false; // Координаты менялись после последней сборки сетки
+    mutable FootpathTable footpaths; // Пешие пересадки между близкими остановками
+    mutable bool footpathsDirty = false; // Координаты менялись после последнего расчета пересадок
+    mutable NetworkIndex networkIndex; // Снимок сети на числовых ID для обходов и аналитики
+    mutable bool networkIndexDirty = false; // Трамваи добавлялись после последней сборки снимка
+    mutable StopGraph routingGraph; // Взвешенный граф перегонов и пешеходных пересадок
+    mutable bool routingGraphDirty = false; // Менялись трамваи или координаты после последней сборки графа
+    TransferPatterns transferPatterns; // Предрасчитанные шаблоны пересадок, сбрасываются при изменении сети
+    ChangeFeed changeFeed; // Подписки на изменения остановок
+    VehiclePositions positions; // Последние положения трамваев из потока обновлений
+    BloomFilter stopFilter; // Фильтр известных имен остановок для быстрого отказа
+    BloomFilter tramFilter; // Фильтр известных имен трамваев
+    size_t removedTrams = 0; // Удаленных трамваев, чьи имена еще остались в фильтре
+    mutable LookupStats stopLookups;
+    mutable LookupStats tramLookups;
+
+    std::map<std::string, Stop>::const_iterator lookupStop(const std::string& stopName) const; // Поиск через фильтр с учетом статистики
+    std::map<std::string, Tram>::const_iterator lookupTram(const std::string& tramName) const;
+    void rebuildFilters(); // Пересоздает фильтры с запасом по размеру
+    void rebuildTramFilter();
+    const DisjointSet& getConnectivity() const; // Пересчитывает компоненты по оставшимся трамваям, если трамваи удалялись
+    // Добавление трамвая без проверок и событий; firstNewId - первый ID остановок, появившихся с ним
+    std::vector<int> attachTram(const std::string& tramName, const std::vector<std::string>& stopNames, int& firstNewId);
+    std::vector<int> detachTram(std::map<std::string, Tram>::iterator it); // Удаление без событий; ID остановок его маршрута
+    // События подписчикам по разнице маршрутов: по одному на остановку, которую трамвай перестал или начал обслуживать
+    void publishRouteChange(const std::string& tramName, const std::vector<int>& oldStops, const std::vector<int>& newStops, int firstNewId);
+    // Уже сохраненные маршруты по хэшу последовательности ID: одинаковые маршруты хранятся один раз
+    std::unordered_map<uint64_t, std::vector<std::shared_ptr<const std::vector<std::string>>>> sharedRoutes;
+    std::unordered_map<uint64_t, std::vector<std::shared_ptr<const std::vector<uint8_t>>>> sharedEncodedRoutes;
+
+    std::vector<int> getRouteIds(const Tram& tram) const; // ID остановок маршрута в порядке следования
+    int getStopId(const std::string& stopName) const; // ID остановки, исключение для неизвестной
+    int findRouteIndex(const std::string& tramName, int stopId) const; // Первая позиция остановки в маршруте, -1 если ее нет
+    int findRouteIndex(int tram, int stopId) const; // То же по ID трамвая в снимке сети
+
+    const StopGraph& getRoutingGraph() const;
+    Journey toJourney(const StopPath& path) const; // Путь на ID в маршрут с именами
+    const SpatialIndex& getSpatialIndex() const; // Пересобирает сетку целиком, если координаты менялись
+    std::vector<std::pair<std::string, double>> toNamedStops(const std::vector<std::pair<int, double>>& found) const;
 
 public:
+    explicit TramSystem(bool compactRoutes = false);
+    TramSystem(const TramSystem&) = delete; // stopById указывает на узлы собственных словарей
+    TramSystem& operator=(const TramSystem&) = delete;
+
     void createTram(const std::string& tramName, const std::vector<std::string>& stopNames);
+    void removeTram(const std::string& tramName); // Удаляет трамвай; остановки остаются, даже если их больше никто не обслуживает
+    void changeTram(const std::string& tramName, const std::vector<std::string>& stopNames); // Заменяет маршрут существующего трамвая
+    ChangeFeed& getChangeFeed(); // Подписки на изменения, которые публикуют createTram, removeTram и changeTram
+    const Stop* findStop(const std::string& stopName) const; // Метод для поиска остановки без копирования, nullptr если ее нет
+    std::vector<const Stop*> getRoute(const std::string& tramName) const; // Метод для получения остановок маршрута по порядку, пусто для неизвестного трамвая
+    const std::map<std::string, Tram>& getTrams() const; // Метод для обхода всех трамваев без копирования
+    size_t getStopCount() const; // Метод для получения количества остановок
+    size_t estimateMemory() const; // Оценка памяти основных структур в байтах
+    const BloomFilter& getStopFilter() const;
+    const BloomFilter& getTramFilter() const;
+    const LookupStats& getStopLookupStats() const;
+    const LookupStats& getTramLookupStats() const;
     std::vector<std::string> getTramsInStop(const std::string& stopName) const; // Метод для получения списка трамваев, которые останавливаются на указанной остановке
     std::vector<std::pair<std::string, std::vector<std::string>>> getStopsInTram(const std::string& tramName) const; // Метод для получения списка остановок, на которых останавливается указанный трамвай
     std::map<std::string, std::vector<std::string>> getAllTrams() const; // Метод для получения всех трамваев и их остановок в виде ассоциативного массива
+    bool areConnected(const std::string& stopA, const std::string& stopB) const; // Метод для проверки, можно ли добраться от одной остановки до другой
+    int getComponentsCount() const; // Метод для получения количества несвязанных подсетей
+
+    void setStopCoordinates(const std::string& stopName, double lat, double lon); // Метод для задания координат существующей остановки
+    int loadCoordinates(const std::string& path); // Метод для загрузки координат из файла строк "<stop> <lat> <lon>", возвращает число загруженных
+    std::vector<std::pair<std::string, double>> getNearestStops(double lat, double lon, int k) const; // k ближайших остановок и расстояния до них в метрах
+    std::vector<std::pair<std::string, double>> getStopsInRadius(double lat, double lon, double radius) const; // Остановки в радиусе (в метрах)
+
+    const FootpathTable& getFootpaths() const; // Таблица пеших пересадок, пересчитывается целиком после изменения координат
+    std::vector<std::pair<std::string, int>> getFootpathsFrom(const std::string& stopName) const; // Пешие пересадки от остановки и время в секундах
+
+    const NetworkIndex& getNetworkIndex() const; // Снимок сети на ID, пересобирается после добавления трамваев
+    std::vector<std::string> getReachableStops(const std::string& stopName, int maxTrams) const; // Остановки, достижимые не более чем на maxTrams трамваях
+    std::vector<int> getReachableCounts(const std::vector<std::string>& stopNames, int maxTrams) const; // Количество достижимых остановок для каждого источника (параллельно)
+
+    std::vector<std::tuple<std::string, std::string, int>> getTramOverlaps(int minShared) const; // Пары трамваев с не менее чем minShared общими остановками
+    std::vector<std::pair<std::string, double>> getHubs(int topN, int samples) const; // topN остановок с наибольшей центральностью по посредничеству
+
+    static constexpr int RIDE_SECONDS_PER_HOP = 120; // Среднее время перегона для прогнозов
+    static constexpr int TRANSFER_SECONDS = 300; // Штраф за пересадку с трамвая на трамвай при поиске маршрутов
+    bool updatePosition(const std::string& tramName, const std::string& stopName, uint32_t timestamp); // Трамвай прошел остановку в момент timestamp; false если данные неверны или устарели
+    int ingestPositions(const std::string& path, int& rejected); // Загрузка потока строк "<tram> <stop> <timestamp>", возвращает число принятых
+    std::vector<PredictedArrival> getNextTrams(const std::string& stopName) const; // Ближайшие прибытия на остановку по времени
+
+    std::vector<Journey> getRoutes(const std::string& fromStop, const std::string& toStop, int k) const; // До k самых быстрых маршрутов без повторения остановок, пересадка стоит TRANSFER_SECONDS
+    void precomputeTransferPatterns(const std::string& path); // Считает шаблоны пересадок для всех пар остановок и сохраняет в файл
+    void loadTransferPatterns(const std::string& path); // Загружает шаблоны, посчитанные для той же сети
+    const TransferPatterns& getTransferPatterns() const; // Для k = 1 getRoutes сначала ищет маршрут по шаблону
 };
 
-#endif // TRAM_SYSTEM_H
\ No newline at end of file
+#endif // TRAM_SYSTEM_H
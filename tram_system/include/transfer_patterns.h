@@ -0,0 +1,57 @@
+#ifndef TRANSFER_PATTERNS_H
+#define TRANSFER_PATTERNS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "routing.h"
+
+// Шаблоны пересадок: для каждой пары остановок - последовательность остановок пересадки
+// на оптимальном пути (отправление, пересадки..., назначение). Шаблоны одной остановки
+// отправления хранятся DAG-ом только из остановок пересадки: узел ссылается на узел предыдущей
+// пересадки, поэтому общие части шаблонов записаны один раз. Назначение ссылается на узел своей
+// последней пересадки через разреженный список; назначения без пересадок (узел - сама остановка
+// отправления) не хранятся вовсе.
+class TransferPatterns {
+public:
+    // Предел размера: узлов и записей назначений по всем остановкам отправления вместе. Запись
+    // занимает 8 байт, так что в памяти это не больше ~256 МБ (файл меньше за счет varint).
+    // Для сети, которой этого мало, build и load отказываются, а ROUTE работает обычным поиском
+    static constexpr size_t MAX_ENTRIES = size_t(1) << 25;
+
+private:
+    // DAG шаблонов одной остановки отправления; узел 0 - сама остановка
+    struct OriginPatterns {
+        std::vector<int> nodeStops; // Остановка пересадки узла
+        std::vector<int> nodeParents; // Узел предыдущей пересадки, -1 у корня
+        std::vector<int> destStops; // Назначения с пересадками по возрастанию
+        std::vector<int> destNodes; // Узел последней пересадки для destStops[i]
+    };
+
+    std::vector<OriginPatterns> origins; // По ID остановки отправления
+    uint64_t fingerprint = 0; // Отпечаток графа, по которому посчитаны шаблоны
+
+public:
+    // Считает шаблоны для всех остановок отправления параллельно; исключение, если они не укладываются в MAX_ENTRIES
+    void build(const StopGraph& graph);
+    void save(const std::string& path) const; // Запись в двоичный файл, исключение при ошибке
+    void load(const std::string& path, const StopGraph& graph); // Чтение файла, исключение если он посчитан для другой сети
+    void clear();
+
+    bool empty() const;
+    size_t patternCount() const; // Количество пар, чей шаблон содержит пересадки
+    size_t nodeCount() const; // Количество узлов во всех DAG-ах
+    // Шаблон пары; для пары без пересадок (или без пути) - {from, to}, expandPattern проверит его по сети
+    std::vector<int> find(int from, int to) const;
+
+    static uint64_t graphFingerprint(const StopGraph& graph);
+};
+
+// Восстанавливает путь по шаблону: каждая пара соседних остановок шаблона должна соединяться
+// одним трамваем без пересадок или пешей пересадкой. Время считается как в графе поиска, с
+// transferSeconds за каждую посадку после первой поездки. false, если шаблон не подходит к сети.
+bool expandPattern(const NetworkIndex& network, const FootpathTable& footpaths, int rideSeconds, int transferSeconds,
+                   const std::vector<int>& pattern, StopPath& path);
+
+#endif // TRANSFER_PATTERNS_H
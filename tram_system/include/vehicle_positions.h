@@ -0,0 +1,49 @@
+#ifndef VEHICLE_POSITIONS_H
+#define VEHICLE_POSITIONS_H
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+
+// Последнее известное положение трамвая: номер пройденной остановки в маршруте и время
+struct VehiclePosition {
+    bool known = false;
+    uint32_t routeIndex = 0;
+    uint32_t timestamp = 0; // Секунды Unix-времени
+};
+
+// Отметка времени из текста: только десятичные цифры, не больше UINT32_MAX; false при ошибке
+bool parseTimestamp(std::string_view text, uint32_t& timestamp);
+
+// Ожидаемое прибытие трамвая на остановку
+struct PredictedArrival {
+    std::string tram;
+    int stopsAway = 0; // Перегонов до остановки от последней пройденной
+    uint32_t eta = 0; // Ожидаемое время прибытия, секунды Unix-времени
+};
+
+// Положения трамваев в слотах без блокировок: каждый слот - одно 64-битное атомарное слово,
+// поэтому читатели никогда не видят половину обновления. Слоты создаются при добавлении
+// трамвая и дальше не перемещаются (узлы std::map стабильны).
+class VehiclePositions {
+public:
+    struct Slot {
+        std::atomic<uint64_t> state{0}; // (timestamp << 32) | (routeIndex + 1), 0 - нет данных
+    };
+
+private:
+    std::map<std::string, Slot> slots;
+
+public:
+    void addTram(const std::string& tramName); // Регистрирует слот; не вызывать одновременно с update
+    void removeTram(const std::string& tramName); // Удаляет слот; не вызывать одновременно с update и get
+    // Записывает положение, если оно не старше уже известного; false для неизвестного трамвая или устаревших данных
+    bool update(const std::string& tramName, uint32_t routeIndex, uint32_t timestamp);
+    Slot* find(const std::string& tramName); // Слот трамвая для повторных обновлений без поиска по имени, nullptr если его нет
+    static bool update(Slot& slot, uint32_t routeIndex, uint32_t timestamp);
+    VehiclePosition get(const std::string& tramName) const;
+};
+
+#endif // VEHICLE_POSITIONS_H
@@ -0,0 +1,156 @@
+#include "analytics.h"
+#include "parallel.h"
+#include <algorithm>
+
+namespace {
+
+// Список смежности графа остановок в CSR-виде без повторяющихся ребер
+void buildStopGraph(const NetworkIndex& network, std::vector<int>& start, std::vector<int>& adjacent) {
+    int stopCount = network.stopCount();
+    std::vector<std::vector<int>> lists(stopCount);
+    for (int tram = 0; tram < network.tramCount(); ++tram) {
+        for (int i = network.tramStopStart[tram] + 1; i < network.tramStopStart[tram + 1]; ++i) {
+            int a = network.tramStops[i - 1];
+            int b = network.tramStops[i];
+            lists[a].push_back(b);
+            lists[b].push_back(a);
+        }
+    }
+
+    start.assign(stopCount + 1, 0);
+    adjacent.clear();
+    for (int stop = 0; stop < stopCount; ++stop) {
+        auto& list = lists[stop];
+        std::sort(list.begin(), list.end());
+        list.erase(std::unique(list.begin(), list.end()), list.end());
+        adjacent.insert(adjacent.end(), list.begin(), list.end());
+        start[stop + 1] = static_cast<int>(adjacent.size());
+    }
+}
+
+} // namespace
+
+std::vector<TramOverlap> tramOverlaps(const NetworkIndex& network, int minShared) {
+    int tramCount = network.tramCount();
+    int stopCount = network.stopCount();
+
+    std::vector<std::vector<TramOverlap>> perWorker(workerCount());
+    parallelFor(tramCount, [&](size_t begin, size_t end, unsigned worker) {
+        std::vector<int> counts(tramCount, 0); // Плотная строка произведения для текущего трамвая
+        std::vector<int> touched; // Ненулевые позиции строки
+        std::vector<int> seenBy(stopCount, -1); // Чтобы повторная остановка маршрута не считалась дважды
+        auto& out = perWorker[worker];
+
+        for (int a = static_cast<int>(begin); a < static_cast<int>(end); ++a) {
+            for (int i = network.tramStopStart[a]; i < network.tramStopStart[a + 1]; ++i) {
+                int stop = network.tramStops[i];
+                if (seenBy[stop] == a) continue;
+                seenBy[stop] = a;
+                for (int t = network.stopTramStart[stop]; t < network.stopTramStart[stop + 1]; ++t) {
+                    int b = network.stopTrams[t];
+                    if (b <= a) continue;
+                    if (counts[b]++ == 0) touched.push_back(b);
+                }
+            }
+
+            for (int b : touched) {
+                if (counts[b] >= minShared) {
+                    out.push_back({a, b, counts[b]});
+                }
+                counts[b] = 0;
+            }
+            touched.clear();
+        }
+    });
+
+    std::vector<TramOverlap> result;
+    for (const auto& part : perWorker) {
+        result.insert(result.end(), part.begin(), part.end());
+    }
+    std::sort(result.begin(), result.end(), [](const TramOverlap& x, const TramOverlap& y) {
+        if (x.shared != y.shared) return x.shared > y.shared;
+        if (x.tramA != y.tramA) return x.tramA < y.tramA;
+        return x.tramB < y.tramB;
+    });
+    return result;
+}
+
+std::vector<double> betweennessCentrality(const NetworkIndex& network, int samples) {
+    int stopCount = network.stopCount();
+    std::vector<int> start, adjacent;
+    buildStopGraph(network, start, adjacent);
+
+    // Источники: все остановки или равномерная выборка
+    std::vector<int> sources;
+    if (samples > 0 && samples < stopCount) {
+        for (int i = 0; i < samples; ++i) {
+            sources.push_back(static_cast<int>(static_cast<long long>(i) * stopCount / samples));
+        }
+    } else {
+        for (int stop = 0; stop < stopCount; ++stop) {
+            sources.push_back(stop);
+        }
+    }
+
+    std::vector<std::vector<double>> perWorker(workerCount());
+    parallelFor(sources.size(), [&](size_t begin, size_t end, unsigned worker) {
+        auto& centrality = perWorker[worker];
+        centrality.assign(stopCount, 0.0);
+        std::vector<int> distance(stopCount, -1);
+        std::vector<double> paths(stopCount, 0.0); // Количество кратчайших путей от источника
+        std::vector<double> dependency(stopCount, 0.0);
+        std::vector<int> order; // Вершины в порядке обхода в ширину
+        order.reserve(stopCount);
+
+        for (size_t s = begin; s < end; ++s) {
+            int source = sources[s];
+            order.clear();
+            distance[source] = 0;
+            paths[source] = 1.0;
+            order.push_back(source);
+            for (size_t head = 0; head < order.size(); ++head) {
+                int v = order[head];
+                for (int e = start[v]; e < start[v + 1]; ++e) {
+                    int w = adjacent[e];
+                    if (distance[w] < 0) {
+                        distance[w] = distance[v] + 1;
+                        order.push_back(w);
+                    }
+                    if (distance[w] == distance[v] + 1) {
+                        paths[w] += paths[v];
+                    }
+                }
+            }
+
+            // Накопление зависимостей в обратном порядке; предшественники восстанавливаются по расстояниям
+            for (size_t i = order.size(); i-- > 0;) {
+                int w = order[i];
+                for (int e = start[w]; e < start[w + 1]; ++e) {
+                    int v = adjacent[e];
+                    if (distance[v] == distance[w] - 1) {
+                        dependency[v] += paths[v] / paths[w] * (1.0 + dependency[w]);
+                    }
+                }
+                if (w != source) {
+                    centrality[w] += dependency[w];
+                }
+            }
+
+            for (int v : order) {
+                distance[v] = -1;
+                paths[v] = 0.0;
+                dependency[v] = 0.0;
+            }
+        }
+    });
+
+    // Каждый путь неориентированного графа учтен с обоих концов
+    double scale = 0.5 * stopCount / std::max<size_t>(sources.size(), 1);
+    std::vector<double> result(stopCount, 0.0);
+    for (const auto& part : perWorker) {
+        for (size_t v = 0; v < part.size(); ++v) {
+            result[v] += part[v] * scale;
+        }
+    }
+    return result;
+}
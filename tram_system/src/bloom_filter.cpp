@@ -0,0 +1,75 @@
+#include "bloom_filter.h"
+#include <algorithm>
+#include <cmath>
+
+uint64_t BloomFilter::hash(const std::string& key) {
+    // FNV-1a с финальным перемешиванием, чтобы младшие и старшие биты были независимы
+    uint64_t h = 1469598103934665603ULL;
+    for (unsigned char c : key) {
+        h ^= c;
+        h *= 1099511628211ULL;
+    }
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return h;
+}
+
+void BloomFilter::reset(size_t expectedKeys) {
+    capacity = std::max<size_t>(expectedKeys, 64);
+    size_t blockCount = (capacity * BITS_PER_KEY + 511) / 512;
+    blocks.assign(blockCount, Block());
+    count = 0;
+}
+
+void BloomFilter::insert(const std::string& key) {
+    if (blocks.empty()) {
+        reset(0);
+    }
+    uint64_t h = hash(key);
+    Block& block = blocks[(h >> 32) % blocks.size()];
+    // Номера битов внутри блока берутся по 9 бит из младшей половины хэша и ее производной
+    uint64_t bitsSource = (h & 0xFFFFFFFFULL) * 0x9E3779B97F4A7C15ULL;
+    for (int i = 0; i < HASHES; ++i) {
+        unsigned bit = static_cast<unsigned>(bitsSource >> (i * 9)) & 511;
+        block.words[bit >> 6] |= uint64_t(1) << (bit & 63);
+    }
+    ++count;
+}
+
+bool BloomFilter::mayContain(const std::string& key) const {
+    if (blocks.empty()) {
+        return false;
+    }
+    uint64_t h = hash(key);
+    const Block& block = blocks[(h >> 32) % blocks.size()];
+    uint64_t bitsSource = (h & 0xFFFFFFFFULL) * 0x9E3779B97F4A7C15ULL;
+    for (int i = 0; i < HASHES; ++i) {
+        unsigned bit = static_cast<unsigned>(bitsSource >> (i * 9)) & 511;
+        if (!(block.words[bit >> 6] & (uint64_t(1) << (bit & 63)))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool BloomFilter::full() const {
+    return count > capacity;
+}
+
+size_t BloomFilter::size() const {
+    return count;
+}
+
+size_t BloomFilter::bits() const {
+    return blocks.size() * 512;
+}
+
+double BloomFilter::estimatedFalsePositiveRate() const {
+    if (blocks.empty()) {
+        return 0.0;
+    }
+    // Оценка для обычного фильтра того же размера; блочный дает немного больше из-за неравномерности блоков
+    double fill = 1.0 - std::exp(-static_cast<double>(HASHES) * count / bits());
+    return std::pow(fill, HASHES);
+}
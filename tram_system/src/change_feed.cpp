@@ -0,0 +1,71 @@
+#include "change_feed.h"
+#include <algorithm>
+
+int ChangeFeed::subscribeStop(const std::string& stop) {
+    int id = nextId++;
+    auto subscriber = std::make_unique<Subscriber>();
+    subscriber->stop = stop;
+    byStop[stop].push_back(subscriber.get());
+    subscribers.emplace(id, std::move(subscriber));
+    return id;
+}
+
+int ChangeFeed::subscribeAll() {
+    int id = nextId++;
+    auto subscriber = std::make_unique<Subscriber>();
+    all.push_back(subscriber.get());
+    subscribers.emplace(id, std::move(subscriber));
+    return id;
+}
+
+bool ChangeFeed::unsubscribe(int id) {
+    auto it = subscribers.find(id);
+    if (it == subscribers.end()) {
+        return false;
+    }
+
+    Subscriber* subscriber = it->second.get();
+    auto& list = subscriber->stop.empty() ? all : byStop[subscriber->stop];
+    list.erase(std::remove(list.begin(), list.end(), subscriber), list.end());
+    if (!subscriber->stop.empty() && list.empty()) {
+        byStop.erase(subscriber->stop);
+    }
+    subscribers.erase(it);
+    return true;
+}
+
+void ChangeFeed::deliver(Subscriber& subscriber, const ChangeEvent& event) {
+    if (!subscriber.queue.push(event)) {
+        subscriber.dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void ChangeFeed::publish(const ChangeEvent& event) {
+    for (Subscriber* subscriber : all) {
+        deliver(*subscriber, event);
+    }
+    auto it = byStop.find(event.stop);
+    if (it != byStop.end()) {
+        for (Subscriber* subscriber : it->second) {
+            deliver(*subscriber, event);
+        }
+    }
+}
+
+bool ChangeFeed::poll(int id, std::vector<ChangeEvent>& events, size_t& dropped) {
+    auto it = subscribers.find(id);
+    if (it == subscribers.end()) {
+        return false;
+    }
+
+    ChangeEvent event;
+    while (it->second->queue.pop(event)) {
+        events.push_back(std::move(event));
+    }
+    dropped = it->second->dropped.exchange(0, std::memory_order_relaxed);
+    return true;
+}
+
+bool ChangeFeed::empty() const {
+    return subscribers.empty();
+}
@@ -12,9 +12,39 @@ Command parseCommand(const std::string& input) {
         std::transform(token.begin(), token.end(), token.begin(), ::toupper);
         
         if (token == "CREATE_TRAM") cmd.type = CommandType::CREATE_TRAM;
+        else if (token == "REMOVE_TRAM") cmd.type = CommandType::REMOVE_TRAM;
+        else if (token == "CHANGE_TRAM") cmd.type = CommandType::CHANGE_TRAM;
         else if (token == "TRAMS_IN_STOP") cmd.type = CommandType::TRAMS_IN_STOP;
         else if (token == "STOPS_IN_TRAM") cmd.type = CommandType::STOPS_IN_TRAM;
         else if (token == "TRAMS") cmd.type = CommandType::TRAMS;
+        else if (token == "CONNECTED") cmd.type = CommandType::CONNECTED;
+        else if (token == "COMPONENTS") cmd.type = CommandType::COMPONENTS;
+        else if (token == "SET_COORDS") cmd.type = CommandType::SET_COORDS;
+        else if (token == "LOAD_COORDS") cmd.type = CommandType::LOAD_COORDS;
+        else if (token == "NEAREST_STOPS") cmd.type = CommandType::NEAREST_STOPS;
+        else if (token == "STOPS_IN_RADIUS") cmd.type = CommandType::STOPS_IN_RADIUS;
+        else if (token == "FOOTPATHS") cmd.type = CommandType::FOOTPATHS;
+        else if (token == "REACHABLE") cmd.type = CommandType::REACHABLE;
+        else if (token == "REACHABLE_BATCH") cmd.type = CommandType::REACHABLE_BATCH;
+        else if (token == "ANALYZE") cmd.type = CommandType::ANALYZE;
+        else if (token == "SUBSCRIBE") cmd.type = CommandType::SUBSCRIBE;
+        else if (token == "UNSUBSCRIBE") cmd.type = CommandType::UNSUBSCRIBE;
+        else if (token == "EVENTS") cmd.type = CommandType::EVENTS;
+        else if (token == "FORMAT") cmd.type = CommandType::FORMAT;
+        else if (token == "USE") cmd.type = CommandType::USE;
+        else if (token == "DROP") cmd.type = CommandType::DROP;
+        else if (token == "TENANTS") cmd.type = CommandType::TENANTS;
+        else if (token == "POSITION") cmd.type = CommandType::POSITION;
+        else if (token == "INGEST") cmd.type = CommandType::INGEST;
+        else if (token == "NEXT_TRAMS") cmd.type = CommandType::NEXT_TRAMS;
+        else if (token == "STATS") cmd.type = CommandType::STATS;
+        else if (token == "DIFF") cmd.type = CommandType::DIFF;
+        else if (token == "ROUTES") cmd.type = CommandType::ROUTES;
+        else if (token == "ROUTE") cmd.type = CommandType::ROUTE;
+        else if (token == "PRECOMPUTE") cmd.type = CommandType::PRECOMPUTE;
+        else if (token == "LOAD_PATTERNS") cmd.type = CommandType::LOAD_PATTERNS;
+        else if (token == "MEMORY") cmd.type = CommandType::MEMORY;
+        else if (token == "TRACE") cmd.type = CommandType::TRACE;
         else cmd.type = CommandType::UNKNOWN;
     }
 
@@ -24,4 +54,13 @@ Command parseCommand(const std::string& input) {
     }
 
     return cmd;
-}
\ No newline at end of file
+}
+bool parseNumber(const std::string& text, double& value) {
+    std::istringstream iss(text);
+    return (iss >> value) && iss.eof();
+}
+
+bool parseNumber(const std::string& text, int& value) {
+    std::istringstream iss(text);
+    return (iss >> value) && iss.eof();
+}
@@ -0,0 +1,43 @@
+#include "disjoint_set.h"
+#include <utility>
+
+int DisjointSet::add() {
+    int x = static_cast<int>(parent.size());
+    parent.push_back(x);
+    size.push_back(1);
+    ++components;
+    return x;
+}
+
+int DisjointSet::find(int x) const {
+    // Сжатие путей делением пополам
+    while (parent[x] != x) {
+        parent[x] = parent[parent[x]];
+        x = parent[x];
+    }
+    return x;
+}
+
+bool DisjointSet::unite(int a, int b) {
+    a = find(a);
+    b = find(b);
+    if (a == b) {
+        return false;
+    }
+    // Объединение по размеру
+    if (size[a] < size[b]) {
+        std::swap(a, b);
+    }
+    parent[b] = a;
+    size[a] += size[b];
+    --components;
+    return true;
+}
+
+bool DisjointSet::connected(int a, int b) const {
+    return find(a) == find(b);
+}
+
+int DisjointSet::count() const {
+    return components;
+}
@@ -0,0 +1,42 @@
+#include "footpaths.h"
+#include "parallel.h"
+#include <cmath>
+
+void FootpathTable::build(const SpatialIndex& index, const std::vector<double>& lats, const std::vector<double>& lons,
+                          const std::vector<char>& hasCoords) {
+    size_t stopCount = hasCoords.size();
+
+    // Каждая остановка пишет только в свой список, поэтому потоки не пересекаются
+    std::vector<std::vector<Footpath>> perStop(stopCount);
+    parallelFor(stopCount, [&](size_t begin, size_t end, unsigned) {
+        for (size_t id = begin; id < end; ++id) {
+            if (!hasCoords[id]) continue;
+            for (const auto& [other, meters] : index.withinRadius(lats[id], lons[id], MAX_WALK_METERS)) {
+                if (other == static_cast<int>(id)) continue;
+                perStop[id].push_back({other, static_cast<int>(std::lround(meters / WALK_SPEED))});
+            }
+        }
+    });
+
+    // Склеиваем списки в один непрерывный массив
+    start.assign(stopCount + 1, 0);
+    for (size_t id = 0; id < stopCount; ++id) {
+        start[id + 1] = start[id] + static_cast<int>(perStop[id].size());
+    }
+    paths.clear();
+    paths.reserve(start[stopCount]);
+    for (auto& list : perStop) {
+        paths.insert(paths.end(), list.begin(), list.end());
+    }
+}
+
+std::pair<const Footpath*, const Footpath*> FootpathTable::from(int stopId) const {
+    if (stopId < 0 || stopId + 1 >= static_cast<int>(start.size())) {
+        return {nullptr, nullptr};
+    }
+    return {paths.data() + start[stopId], paths.data() + start[stopId + 1]};
+}
+
+size_t FootpathTable::size() const {
+    return paths.size();
+}
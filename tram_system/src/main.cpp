@@ -1,102 +1,745 @@
 #include "tram_system.h"
+#include "tenants.h"
 #include "commands.h"
+#include "output_writer.h"
+#include "network_diff.h"
+#include "memory_tracker.h"
+#include "trace.h"
 #include <iostream>
+#include <cstring>
+#include <algorithm>
+#include <chrono>
 
 
+// Статистика фильтра Блума и поисков по именам
+void writeFilterStats(OutputWriter& out, std::string_view kind, const BloomFilter& filter, const LookupStats& stats) {
+    uint64_t misses = stats.rejected + stats.falsePositives;
+    out.beginRecord("Filter");
+    out.field("names", kind);
+    out.number("keys", static_cast<double>(filter.size()), 0, " keys");
+    out.number("bits", static_cast<double>(filter.bits()), 0, " bits");
+    out.number("lookups", static_cast<double>(stats.lookups), 0, " lookups");
+    out.number("rejected", static_cast<double>(stats.rejected), 0, " rejected");
+    out.number("false_positives", static_cast<double>(stats.falsePositives), 0, " false positives");
+    out.number("observed_fp_percent", misses ? 100.0 * stats.falsePositives / misses : 0.0, 3, "% observed FP");
+    out.number("estimated_fp_percent", 100.0 * filter.estimatedFalsePositiveRate(), 3, "% estimated FP");
+    out.endRecord();
+}
+
+// Команда трамвая с маршрутом одной строкой, чтобы список изменений DIFF можно было выполнить как есть
+std::string tramCommand(std::string_view command, const std::string& tram, const std::vector<std::string>& stops) {
+    std::string line(command);
+    line += ' ';
+    line += tram;
+    for (const auto& stop : stops) {
+        line += ' ';
+        line += stop;
+    }
+    return line;
+}
+
+// Вывод найденных остановок с расстоянием в метрах
+void writeStopsWithDistance(OutputWriter& out, const std::vector<std::pair<std::string, double>>& found) {
+    if (found.empty()) {
+        out.message({"No stops found"});
+        return;
+    }
+    for (const auto& [stop, distance] : found) {
+        out.beginRecord("");
+        out.field("stop", stop);
+        out.number("meters", distance, 0, "m");
+        out.endRecord();
+    }
+}
+
 //доступные команды
 void printHelp() {
     std::cout << "Available commands:\n"
               << "CREATE_TRAM <number> <stop1> <stop2> ...\n"
+              << "REMOVE_TRAM <number>\n"
+              << "CHANGE_TRAM <number> <stop1> <stop2> ...\n"
               << "TRAMS_IN_STOP <stop>\n"
               << "STOPS_IN_TRAM <number>\n"
               << "TRAMS\n"
+              << "CONNECTED <stop1> <stop2>\n"
+              << "COMPONENTS\n"
+              << "SET_COORDS <stop> <lat> <lon>\n"
+              << "LOAD_COORDS <file>\n"
+              << "NEAREST_STOPS <lat> <lon> <k>\n"
+              << "STOPS_IN_RADIUS <lat> <lon> <meters>\n"
+              << "FOOTPATHS <stop>\n"
+              << "REACHABLE <stop> <k>\n"
+              << "REACHABLE_BATCH <k> <stop1> <stop2> ...\n"
+              << "ANALYZE OVERLAP [min_shared]\n"
+              << "ANALYZE HUBS [top_n] [samples]\n"
+              << "SUBSCRIBE STOP <stop> | SUBSCRIBE ALL\n"
+              << "EVENTS <subscription>\n"
+              << "UNSUBSCRIBE <subscription>\n"
+              << "FORMAT <text|json|binary>\n"
+              << "USE <city>\n"
+              << "DROP <city>\n"
+              << "TENANTS\n"
+              << "POSITION <number> <stop> <timestamp>\n"
+              << "INGEST <file>\n"
+              << "NEXT_TRAMS <stop>\n"
+              << "STATS\n"
+              << "DIFF <fileA> <fileB>\n"
+              << "ROUTES <from> <to> <k>\n"
+              << "ROUTE <from> <to>\n"
+              << "PRECOMPUTE TRANSFER_PATTERNS <file>\n"
+              << "LOAD_PATTERNS <file>\n"
+              << "MEMORY\n"
+              << "TRACE <ON|OFF> | TRACE DUMP <file>\n"
               << "EXIT\n";
 }
 
-int main() {
-    TramSystem system;
+int main(int argc, char* argv[]) {
+    // --compact: хранить маршруты в виде delta/varint-потока ID остановок
+    // --format=<text|json|binary>: протокол вывода ответов
+    bool compactRoutes = false;
+    OutputFormat format = OutputFormat::TEXT;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--compact") == 0) compactRoutes = true;
+        else if (std::strncmp(argv[i], "--format=", 9) == 0 && !parseOutputFormat(argv[i] + 9, format)) {
+            std::cerr << "Unknown output format: " << (argv[i] + 9) << "\n";
+            return 1;
+        }
+    }
+
+    Tenants tenants(compactRoutes);
+    OutputWriter out(std::cout, format);
     std::string input;
     
-    printHelp();
+    if (format == OutputFormat::TEXT) printHelp();
     
     while (true) {
-        std::cout << "> ";
+        if (out.getFormat() == OutputFormat::TEXT) std::cout << "> ";
         std::getline(std::cin, input);
-        
-        Command cmd = parseCommand(input);
-        
+        if (!input.empty() && input[0] == '#') continue; // Комментарий, например пояснения в выводе DIFF
+        TraceSpan commandSpan("command", std::string_view(input).substr(0, input.find(' ')));
+
+        Command cmd;
+        {
+            TraceSpan span("parseCommand");
+            cmd = parseCommand(input);
+        }
+        if (cmd.type == CommandType::UNKNOWN && input == "EXIT") return 0;
+
+        TramSystem& system = tenants.current();
+        if (cmd.type != CommandType::USE) {
+            tenants.countQuery(); // USE учитывается за город, который выбирает
+        }
+
+        out.beginResponse();
+        TraceSpan assembleSpan("assemble"); // Выполнение команды и сборка ответа, поиски вложены в него
         switch (cmd.type) {
             case CommandType::CREATE_TRAM: {
                 if (cmd.args.size() < 2) {
-                    std::cout << "Error: Need tram number and at least 2 stops\n";
+                    out.error({"Need tram number and at least 2 stops"});
                     break;
                 }
                 try {
                     std::vector<std::string> stops(cmd.args.begin() + 1, cmd.args.end());
                     system.createTram(cmd.args[0], stops);
-                    std::cout << "Tram " << cmd.args[0] << " created successfully\n";
+                    out.message({"Tram ", cmd.args[0], " created successfully"});
+                } catch (const std::invalid_argument& e) {
+                    out.error({e.what()});
+                }
+                break;
+            }
+            case CommandType::REMOVE_TRAM: {
+                if (cmd.args.empty()) {
+                    out.error({"Specify tram number"});
+                    break;
+                }
+                try {
+                    system.removeTram(cmd.args[0]);
+                    out.message({"Tram ", cmd.args[0], " removed"});
                 } catch (const std::invalid_argument& e) {
-                    std::cout << "Error: " << e.what() << "\n";
+                    out.error({e.what()});
+                }
+                break;
+            }
+            case CommandType::CHANGE_TRAM: {
+                if (cmd.args.size() < 2) {
+                    out.error({"Need tram number and at least 2 stops"});
+                    break;
+                }
+                try {
+                    std::vector<std::string> stops(cmd.args.begin() + 1, cmd.args.end());
+                    system.changeTram(cmd.args[0], stops);
+                    out.message({"Tram ", cmd.args[0], " changed"});
+                } catch (const std::invalid_argument& e) {
+                    out.error({e.what()});
                 }
                 break;
             }
             case CommandType::TRAMS_IN_STOP: {
                 if (cmd.args.empty()) {
-                    std::cout << "Error: Specify stop name\n";
+                    out.error({"Specify stop name"});
                     break;
                 }
-                auto trams = system.getTramsInStop(cmd.args[0]);
-                if (trams.empty()) {
-                    std::cout << "No trams for this stop\n";
+                const Stop* stop = system.findStop(cmd.args[0]);
+                if (!stop || stop->getTrams().empty()) {
+                    out.message({"No trams for this stop"});
                 } else {
-                    for (const auto& tram : trams) {
-                        std::cout << tram << " ";
+                    out.beginRecord("");
+                    out.beginList("trams");
+                    for (const auto& tram : stop->getTrams()) {
+                        out.item(tram);
                     }
-                    std::cout << "\n";
+                    out.endList();
+                    out.endRecord();
                 }
                 break;
             }
             case CommandType::STOPS_IN_TRAM: {
                 if (cmd.args.empty()) {
-                    std::cout << "Error: Specify tram number\n";
+                    out.error({"Specify tram number"});
                     break;
                 }
-                auto stops = system.getStopsInTram(cmd.args[0]);
-                if (stops.empty()) {
-                    std::cout << "No stops for this tram\n";
+                auto route = system.getRoute(cmd.args[0]);
+                if (route.empty()) {
+                    out.message({"No stops for this tram"});
                 } else {
-                    for (const auto& [stop, connected] : stops) {
-                        std::cout << "Stop " << stop << ": ";
-                        for (const auto& tram : connected) {
-                            std::cout << tram << " ";
+                    for (const Stop* stop : route) {
+                        out.beginRecord("Stop");
+                        out.field("stop", stop->getName());
+                        out.beginList("trams");
+                        for (const auto& tram : stop->getTrams()) {
+                            if (tram != cmd.args[0]) out.item(tram);
                         }
-                        std::cout << "\n";
+                        out.endList();
+                        out.endRecord();
                     }
                 }
                 break;
             }
             case CommandType::TRAMS: {
-                auto allTrams = system.getAllTrams();
-                if (allTrams.empty()) {
-                    std::cout << "No trams in system\n";
+                if (system.getTrams().empty()) {
+                    out.message({"No trams in system"});
                 } else {
-                    for (const auto& [number, stops] : allTrams) {
-                        std::cout << "TRAM " << number << ": ";
-                        for (const auto& stop : stops) {
-                            std::cout << stop << " ";
+                    for (const auto& [number, tram] : system.getTrams()) {
+                        out.beginRecord("TRAM");
+                        out.field("tram", number);
+                        out.beginList("stops");
+                        for (const Stop* stop : system.getRoute(number)) {
+                            out.item(stop->getName());
                         }
-                        std::cout << "\n";
+                        out.endList();
+                        out.endRecord();
                     }
                 }
                 break;
             }
+            case CommandType::CONNECTED: {
+                if (cmd.args.size() < 2) {
+                    out.error({"Specify two stop names"});
+                    break;
+                }
+                try {
+                    bool connected = system.areConnected(cmd.args[0], cmd.args[1]);
+                    out.message({connected ? "Connected" : "Not connected"});
+                } catch (const std::invalid_argument& e) {
+                    out.error({e.what()});
+                }
+                break;
+            }
+            case CommandType::COMPONENTS: {
+                out.beginRecord("Components");
+                out.number("count", system.getComponentsCount());
+                out.endRecord();
+                break;
+            }
+            case CommandType::SET_COORDS: {
+                double lat, lon;
+                if (cmd.args.size() < 3 || !parseNumber(cmd.args[1], lat) || !parseNumber(cmd.args[2], lon)) {
+                    out.error({"Specify stop name, latitude and longitude"});
+                    break;
+                }
+                try {
+                    system.setStopCoordinates(cmd.args[0], lat, lon);
+                    out.message({"Coordinates of stop ", cmd.args[0], " set"});
+                } catch (const std::invalid_argument& e) {
+                    out.error({e.what()});
+                }
+                break;
+            }
+            case CommandType::LOAD_COORDS: {
+                if (cmd.args.empty()) {
+                    out.error({"Specify file name"});
+                    break;
+                }
+                try {
+                    int loaded = system.loadCoordinates(cmd.args[0]);
+                    out.message({"Loaded coordinates for ", std::to_string(loaded), " stops"});
+                } catch (const std::invalid_argument& e) {
+                    out.error({e.what()});
+                }
+                break;
+            }
+            case CommandType::NEAREST_STOPS: {
+                double lat, lon;
+                int k;
+                if (cmd.args.size() < 3 || !parseNumber(cmd.args[0], lat) || !parseNumber(cmd.args[1], lon)
+                    || !parseNumber(cmd.args[2], k)) {
+                    out.error({"Specify latitude, longitude and number of stops"});
+                    break;
+                }
+                writeStopsWithDistance(out, system.getNearestStops(lat, lon, k));
+                break;
+            }
+            case CommandType::STOPS_IN_RADIUS: {
+                double lat, lon, radius;
+                if (cmd.args.size() < 3 || !parseNumber(cmd.args[0], lat) || !parseNumber(cmd.args[1], lon)
+                    || !parseNumber(cmd.args[2], radius)) {
+                    out.error({"Specify latitude, longitude and radius in meters"});
+                    break;
+                }
+                writeStopsWithDistance(out, system.getStopsInRadius(lat, lon, radius));
+                break;
+            }
+            case CommandType::FOOTPATHS: {
+                if (cmd.args.empty()) {
+                    out.error({"Specify stop name"});
+                    break;
+                }
+                try {
+                    auto paths = system.getFootpathsFrom(cmd.args[0]);
+                    if (paths.empty()) {
+                        out.message({"No walking transfers for this stop"});
+                    }
+                    for (const auto& [stop, seconds] : paths) {
+                        out.beginRecord("");
+                        out.field("stop", stop);
+                        out.number("seconds", seconds, 0, "s");
+                        out.endRecord();
+                    }
+                } catch (const std::invalid_argument& e) {
+                    out.error({e.what()});
+                }
+                break;
+            }
+            case CommandType::REACHABLE: {
+                int k;
+                if (cmd.args.size() < 2 || !parseNumber(cmd.args[1], k) || k < 0) {
+                    out.error({"Specify stop name and maximum number of trams"});
+                    break;
+                }
+                try {
+                    auto reachable = system.getReachableStops(cmd.args[0], k);
+                    out.beginRecord("Reachable stops");
+                    out.number("count", static_cast<double>(reachable.size()));
+                    out.beginList("stops");
+                    for (const auto& stop : reachable) {
+                        out.item(stop);
+                    }
+                    out.endList();
+                    out.endRecord();
+                } catch (const std::invalid_argument& e) {
+                    out.error({e.what()});
+                }
+                break;
+            }
+            case CommandType::REACHABLE_BATCH: {
+                int k;
+                if (cmd.args.size() < 2 || !parseNumber(cmd.args[0], k) || k < 0) {
+                    out.error({"Specify maximum number of trams and at least one stop"});
+                    break;
+                }
+                try {
+                    std::vector<std::string> origins(cmd.args.begin() + 1, cmd.args.end());
+                    auto counts = system.getReachableCounts(origins, k);
+                    for (size_t i = 0; i < origins.size(); ++i) {
+                        out.beginRecord("Stop");
+                        out.field("stop", origins[i]);
+                        out.number("reachable", counts[i]);
+                        out.endRecord();
+                    }
+                } catch (const std::invalid_argument& e) {
+                    out.error({e.what()});
+                }
+                break;
+            }
+            case CommandType::ANALYZE: {
+                std::string job = cmd.args.empty() ? "" : cmd.args[0];
+                std::transform(job.begin(), job.end(), job.begin(), ::toupper);
+                if (job == "OVERLAP") {
+                    int minShared = 2;
+                    if (cmd.args.size() > 1 && (!parseNumber(cmd.args[1], minShared) || minShared < 1)) {
+                        out.error({"min_shared must be a positive number"});
+                        break;
+                    }
+                    auto overlaps = system.getTramOverlaps(minShared);
+                    if (overlaps.empty()) {
+                        out.message({"No overlapping trams"});
+                    }
+                    for (const auto& [tramA, tramB, shared] : overlaps) {
+                        out.beginRecord("Trams");
+                        out.field("tram_a", tramA);
+                        out.field("tram_b", tramB);
+                        out.number("shared_stops", shared, 0, " shared stops");
+                        out.endRecord();
+                    }
+                } else if (job == "HUBS") {
+                    int topN = 10, samples = 0;
+                    if ((cmd.args.size() > 1 && (!parseNumber(cmd.args[1], topN) || topN < 1))
+                        || (cmd.args.size() > 2 && (!parseNumber(cmd.args[2], samples) || samples < 1))) {
+                        out.error({"top_n and samples must be positive numbers"});
+                        break;
+                    }
+                    auto hubs = system.getHubs(topN, samples);
+                    if (hubs.empty()) {
+                        out.message({"No stops in system"});
+                    }
+                    for (const auto& [stop, centrality] : hubs) {
+                        out.beginRecord("Stop");
+                        out.field("stop", stop);
+                        out.number("betweenness", centrality, 2);
+                        out.endRecord();
+                    }
+                } else {
+                    out.error({"Unknown analysis, use ANALYZE OVERLAP or ANALYZE HUBS"});
+                }
+                break;
+            }
+            case CommandType::SUBSCRIBE: {
+                std::string target = cmd.args.empty() ? "" : cmd.args[0];
+                std::transform(target.begin(), target.end(), target.begin(), ::toupper);
+                int id;
+                if (target == "ALL") {
+                    id = system.getChangeFeed().subscribeAll();
+                } else if (target == "STOP" && cmd.args.size() > 1) {
+                    id = system.getChangeFeed().subscribeStop(cmd.args[1]);
+                } else {
+                    out.error({"Use SUBSCRIBE STOP <stop> or SUBSCRIBE ALL"});
+                    break;
+                }
+                out.message({"Subscription ", std::to_string(id), " created"});
+                break;
+            }
+            case CommandType::UNSUBSCRIBE: {
+                int id;
+                if (cmd.args.empty() || !parseNumber(cmd.args[0], id)) {
+                    out.error({"Specify subscription number"});
+                    break;
+                }
+                if (system.getChangeFeed().unsubscribe(id)) {
+                    out.message({"Subscription ", cmd.args[0], " removed"});
+                } else {
+                    out.error({"Unknown subscription"});
+                }
+                break;
+            }
+            case CommandType::EVENTS: {
+                int id;
+                if (cmd.args.empty() || !parseNumber(cmd.args[0], id)) {
+                    out.error({"Specify subscription number"});
+                    break;
+                }
+                std::vector<ChangeEvent> events;
+                size_t dropped = 0;
+                if (!system.getChangeFeed().poll(id, events, dropped)) {
+                    out.error({"Unknown subscription"});
+                    break;
+                }
+                if (events.empty() && dropped == 0) {
+                    out.message({"No new events"});
+                }
+                for (const auto& event : events) {
+                    if (event.removed) {
+                        out.message({"Tram ", event.tram, " no longer serves stop ", event.stop});
+                    } else {
+                        out.message({"Tram ", event.tram, " serves ", event.newStop ? "new " : "", "stop ", event.stop});
+                    }
+                }
+                if (dropped > 0) {
+                    out.message({std::to_string(dropped), " events dropped"});
+                }
+                break;
+            }
+            case CommandType::FORMAT: {
+                OutputFormat newFormat;
+                if (cmd.args.empty() || !parseOutputFormat(cmd.args[0], newFormat)) {
+                    out.error({"Specify output format: text, json or binary"});
+                    break;
+                }
+                out.setFormat(newFormat);
+                out.beginResponse();
+                out.message({"Output format changed"});
+                break;
+            }
+            case CommandType::USE: {
+                if (cmd.args.empty()) {
+                    out.error({"Specify city name"});
+                    break;
+                }
+                bool created = tenants.use(cmd.args[0]);
+                tenants.countQuery();
+                out.message({"Using city ", cmd.args[0], created ? " (created)" : ""});
+                break;
+            }
+            case CommandType::DROP: {
+                if (cmd.args.empty()) {
+                    out.error({"Specify city name"});
+                    break;
+                }
+                try {
+                    tenants.drop(cmd.args[0]);
+                    out.message({"City ", cmd.args[0], " dropped"});
+                } catch (const std::invalid_argument& e) {
+                    out.error({e.what()});
+                }
+                break;
+            }
+            case CommandType::TENANTS: {
+                for (const auto& stats : tenants.getStats()) {
+                    out.beginRecord(stats.name == tenants.getCurrentName() ? "City*" : "City");
+                    out.field("city", stats.name);
+                    out.number("trams", static_cast<double>(stats.trams), 0, " trams");
+                    out.number("stops", static_cast<double>(stats.stops), 0, " stops");
+                    out.number("memory_bytes", static_cast<double>(stats.memoryBytes), 0, " bytes");
+                    out.number("queries", static_cast<double>(stats.queries), 0, " queries");
+                    out.endRecord();
+                }
+                break;
+            }
+            case CommandType::POSITION: {
+                uint32_t timestamp;
+                if (cmd.args.size() < 3 || !parseTimestamp(cmd.args[2], timestamp)) {
+                    out.error({"Specify tram number, last passed stop and timestamp"});
+                    break;
+                }
+                if (system.updatePosition(cmd.args[0], cmd.args[1], timestamp)) {
+                    out.message({"Position of tram ", cmd.args[0], " updated"});
+                } else {
+                    out.error({"Unknown tram or stop, or outdated position"});
+                }
+                break;
+            }
+            case CommandType::INGEST: {
+                if (cmd.args.empty()) {
+                    out.error({"Specify file name"});
+                    break;
+                }
+                try {
+                    auto started = std::chrono::steady_clock::now();
+                    int rejected = 0;
+                    int accepted = system.ingestPositions(cmd.args[0], rejected);
+                    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+                    out.beginRecord("Ingested");
+                    out.number("accepted", accepted, 0, " accepted");
+                    out.number("rejected", rejected, 0, " rejected");
+                    out.number("updates_per_second", seconds > 0 ? (accepted + rejected) / seconds : 0, 0, " updates/s");
+                    out.endRecord();
+                } catch (const std::invalid_argument& e) {
+                    out.error({e.what()});
+                }
+                break;
+            }
+            case CommandType::NEXT_TRAMS: {
+                if (cmd.args.empty()) {
+                    out.error({"Specify stop name"});
+                    break;
+                }
+                try {
+                    auto arrivals = system.getNextTrams(cmd.args[0]);
+                    if (arrivals.empty()) {
+                        out.message({"No approaching trams"});
+                    }
+                    for (const auto& arrival : arrivals) {
+                        out.beginRecord("Tram");
+                        out.field("tram", arrival.tram);
+                        out.number("stops_away", arrival.stopsAway, 0, " stops away");
+                        out.number("eta", arrival.eta, 0);
+                        out.endRecord();
+                    }
+                } catch (const std::invalid_argument& e) {
+                    out.error({e.what()});
+                }
+                break;
+            }
+            case CommandType::STATS: {
+                out.beginRecord("Trams");
+                out.number("trams", static_cast<double>(system.getTrams().size()));
+                out.endRecord();
+                out.beginRecord("Stops");
+                out.number("stops", static_cast<double>(system.getStopCount()));
+                out.endRecord();
+                writeFilterStats(out, "stops", system.getStopFilter(), system.getStopLookupStats());
+                writeFilterStats(out, "trams", system.getTramFilter(), system.getTramLookupStats());
+                break;
+            }
+            case CommandType::DIFF: {
+                if (cmd.args.size() < 2) {
+                    out.error({"Specify two route files"});
+                    break;
+                }
+                try {
+                    // Строки изменений - готовые команды, сводка по остановкам идет комментариями
+                    NetworkDiff diff = diffNetworks(loadRouteSet(cmd.args[0]), loadRouteSet(cmd.args[1]));
+                    for (const auto& tram : diff.removedTrams) {
+                        out.message({"REMOVE_TRAM ", tram});
+                    }
+                    for (const auto& [tram, stops] : diff.changedTrams) {
+                        out.message({tramCommand("CHANGE_TRAM", tram, stops)});
+                    }
+                    for (const auto& [tram, stops] : diff.addedTrams) {
+                        out.message({tramCommand("CREATE_TRAM", tram, stops)});
+                    }
+                    for (const auto& stop : diff.addedStops) {
+                        out.message({"# NEW_STOP ", stop});
+                    }
+                    for (const auto& stop : diff.lostService) {
+                        out.message({"# LOST_SERVICE ", stop});
+                    }
+                    if (diff.removedTrams.empty() && diff.changedTrams.empty() && diff.addedTrams.empty()) {
+                        out.message({"# Networks are identical"});
+                    }
+                } catch (const std::invalid_argument& e) {
+                    out.error({e.what()});
+                }
+                break;
+            }
+            case CommandType::ROUTES:
+            case CommandType::ROUTE: {
+                int k = 1;
+                if (cmd.args.size() < 2 || (cmd.type == CommandType::ROUTES && (cmd.args.size() < 3 || !parseNumber(cmd.args[2], k)))) {
+                    out.error({cmd.type == CommandType::ROUTES ? "Specify two stops and number of routes" : "Specify two stops"});
+                    break;
+                }
+                try {
+                    auto journeys = system.getRoutes(cmd.args[0], cmd.args[1], k);
+                    if (journeys.empty()) {
+                        out.message({"No route found"});
+                    }
+                    for (size_t i = 0; i < journeys.size(); ++i) {
+                        out.beginRecord("Route");
+                        out.field("route", std::to_string(i + 1));
+                        out.number("seconds", journeys[i].seconds, 0, "s");
+                        out.beginList("stops");
+                        for (const auto& stop : journeys[i].stops) {
+                            out.item(stop);
+                        }
+                        out.endList();
+                        out.endRecord();
+                        for (const auto& leg : journeys[i].legs) {
+                            out.beginRecord("Leg");
+                            if (leg.tram.empty()) {
+                                out.field("mode", "walk");
+                            } else {
+                                out.field("mode", "tram");
+                                out.field("tram", leg.tram);
+                            }
+                            out.beginList("stops");
+                            out.item(leg.from);
+                            out.item(leg.to);
+                            out.endList();
+                            out.endRecord();
+                        }
+                    }
+                } catch (const std::invalid_argument& e) {
+                    out.error({e.what()});
+                }
+                break;
+            }
+            case CommandType::PRECOMPUTE:
+            case CommandType::LOAD_PATTERNS: {
+                std::string job = cmd.type == CommandType::PRECOMPUTE && !cmd.args.empty() ? cmd.args[0] : "TRANSFER_PATTERNS";
+                std::transform(job.begin(), job.end(), job.begin(), ::toupper);
+                size_t fileArg = cmd.type == CommandType::PRECOMPUTE ? 1 : 0;
+                if (job != "TRANSFER_PATTERNS") {
+                    out.error({"Unknown job, use PRECOMPUTE TRANSFER_PATTERNS <file>"});
+                    break;
+                }
+                if (cmd.args.size() <= fileArg) {
+                    out.error({"Specify file name"});
+                    break;
+                }
+                try {
+                    auto started = std::chrono::steady_clock::now();
+                    if (cmd.type == CommandType::PRECOMPUTE) {
+                        system.precomputeTransferPatterns(cmd.args[fileArg]);
+                    } else {
+                        system.loadTransferPatterns(cmd.args[fileArg]);
+                    }
+                    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+                    const TransferPatterns& patterns = system.getTransferPatterns();
+                    out.beginRecord("Transfer patterns");
+                    out.number("patterns", static_cast<double>(patterns.patternCount()), 0, " patterns");
+                    out.number("nodes", static_cast<double>(patterns.nodeCount()), 0, " nodes");
+                    out.number("ms", ms, 1, " ms");
+                    out.endRecord();
+                } catch (const std::invalid_argument& e) {
+                    out.error({e.what()});
+                }
+                break;
+            }
+            case CommandType::MEMORY: {
+                if (!memoryTrackingEnabled()) {
+                    out.message({"Memory tracking is disabled, rebuild with -DTRAM_TRACK_MEMORY=ON"});
+                    out.beginRecord("Estimated");
+                    out.number("bytes", static_cast<double>(system.estimateMemory()), 0, " bytes");
+                    out.endRecord();
+                    break;
+                }
+                // Счетчики общие для процесса: в них входят все города и служебные выделения
+                MemoryUsage total;
+                for (int i = 0; i < static_cast<int>(MemoryCategory::COUNT); ++i) {
+                    MemoryCategory category = static_cast<MemoryCategory>(i);
+                    MemoryUsage usage = getMemoryUsage(category);
+                    total.bytes += usage.bytes;
+                    total.blocks += usage.blocks;
+                    total.allocations += usage.allocations;
+                    out.beginRecord("Memory");
+                    out.field("category", getMemoryCategoryName(category));
+                    out.number("bytes", static_cast<double>(usage.bytes), 0, " bytes");
+                    out.number("blocks", static_cast<double>(usage.blocks), 0, " blocks");
+                    out.number("allocations", static_cast<double>(usage.allocations), 0, " allocations");
+                    out.endRecord();
+                }
+                out.beginRecord("Total");
+                out.number("bytes", static_cast<double>(total.bytes), 0, " bytes");
+                out.number("blocks", static_cast<double>(total.blocks), 0, " blocks");
+                out.number("allocations", static_cast<double>(total.allocations), 0, " allocations");
+                out.endRecord();
+                break;
+            }
+            case CommandType::TRACE: {
+                std::string mode = cmd.args.empty() ? "" : cmd.args[0];
+                std::transform(mode.begin(), mode.end(), mode.begin(), ::toupper);
+                if (mode == "ON" || mode == "OFF") {
+                    setTraceEnabled(mode == "ON");
+                    out.message({"Tracing ", mode == "ON" ? "enabled" : "disabled"});
+                } else if (mode == "DUMP" && cmd.args.size() > 1) {
+                    try {
+                        size_t dropped = 0;
+                        size_t events = writeTrace(cmd.args[1], dropped);
+                        out.beginRecord("Trace");
+                        out.number("events", static_cast<double>(events), 0, " events");
+                        out.number("dropped", static_cast<double>(dropped), 0, " dropped");
+                        out.endRecord();
+                    } catch (const std::invalid_argument& e) {
+                        out.error({e.what()});
+                    }
+                } else {
+                    out.error({"Use TRACE ON, TRACE OFF or TRACE DUMP <file>"});
+                }
+                break;
+            }
             case CommandType::UNKNOWN: {
-                if (input == "EXIT") return 0;
-                std::cout << "Unknown command\n";
-                printHelp();
+                out.message({"Unknown command"});
+                if (out.getFormat() == OutputFormat::TEXT) {
+                    out.endResponse();
+                    printHelp();
+                    continue;
+                }
                 break;
             }
         }
+        assembleSpan.end();
+        TraceSpan outputSpan("output");
+        out.endResponse();
     }
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,178 @@
+#include "memory_tracker.h"
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+const size_t CATEGORY_COUNT = static_cast<size_t>(MemoryCategory::COUNT);
+
+thread_local MemoryCategory currentCategory = MemoryCategory::OTHER;
+
+#ifdef TRAM_TRACK_MEMORY
+
+std::atomic<size_t> liveBytes[CATEGORY_COUNT];
+std::atomic<size_t> liveBlocks[CATEGORY_COUNT];
+std::atomic<size_t> totalAllocations[CATEGORY_COUNT];
+
+// Заголовок перед каждым блоком: освобождение вычитается из той категории, в которой блок выделен
+struct alignas(std::max_align_t) BlockHeader {
+    size_t size;
+    size_t category;
+};
+
+// Заголовок блока с выравниванием больше стандартного (alignas(64) и т.п.): отступ до выровненного
+// адреса зависит от malloc, поэтому начало выделенной памяти хранится в заголовке
+struct AlignedBlockHeader {
+    void* base;
+    size_t size;
+    size_t category;
+};
+
+size_t recordAlloc(size_t size) { // Категория, в которую записан блок
+    size_t category = static_cast<size_t>(currentCategory);
+    liveBytes[category].fetch_add(size, std::memory_order_relaxed);
+    liveBlocks[category].fetch_add(1, std::memory_order_relaxed);
+    totalAllocations[category].fetch_add(1, std::memory_order_relaxed);
+    return category;
+}
+
+void recordFree(size_t category, size_t size) {
+    liveBytes[category].fetch_sub(size, std::memory_order_relaxed);
+    liveBlocks[category].fetch_sub(1, std::memory_order_relaxed);
+}
+
+void* trackedAlloc(size_t size) {
+    auto* header = static_cast<BlockHeader*>(std::malloc(sizeof(BlockHeader) + size));
+    if (!header) {
+        return nullptr;
+    }
+    header->size = size;
+    header->category = recordAlloc(size);
+    return header + 1;
+}
+
+void trackedFree(void* ptr) {
+    if (!ptr) {
+        return;
+    }
+    BlockHeader* header = static_cast<BlockHeader*>(ptr) - 1;
+    recordFree(header->category, header->size);
+    std::free(header);
+}
+
+void* trackedAlignedAlloc(size_t size, std::align_val_t alignment) {
+    size_t align = static_cast<size_t>(alignment);
+    void* base = std::malloc(sizeof(AlignedBlockHeader) + align - 1 + size);
+    if (!base) {
+        return nullptr;
+    }
+    uintptr_t address = (reinterpret_cast<uintptr_t>(base) + sizeof(AlignedBlockHeader) + align - 1) & ~(uintptr_t(align) - 1);
+    auto* header = reinterpret_cast<AlignedBlockHeader*>(address) - 1;
+    header->base = base;
+    header->size = size;
+    header->category = recordAlloc(size);
+    return reinterpret_cast<void*>(address);
+}
+
+void trackedAlignedFree(void* ptr) {
+    if (!ptr) {
+        return;
+    }
+    AlignedBlockHeader* header = static_cast<AlignedBlockHeader*>(ptr) - 1;
+    recordFree(header->category, header->size);
+    std::free(header->base);
+}
+
+void* trackedNew(size_t size) {
+    void* ptr = trackedAlloc(size);
+    if (!ptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void* trackedAlignedNew(size_t size, std::align_val_t alignment) {
+    void* ptr = trackedAlignedAlloc(size, alignment);
+    if (!ptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+#endif // TRAM_TRACK_MEMORY
+
+} // namespace
+
+#ifdef TRAM_TRACK_MEMORY
+
+void* operator new(size_t size) { return trackedNew(size); }
+void* operator new[](size_t size) { return trackedNew(size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return trackedAlloc(size); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return trackedAlloc(size); }
+void operator delete(void* ptr) noexcept { trackedFree(ptr); }
+void operator delete[](void* ptr) noexcept { trackedFree(ptr); }
+void operator delete(void* ptr, size_t) noexcept { trackedFree(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { trackedFree(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { trackedFree(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { trackedFree(ptr); }
+
+void* operator new(size_t size, std::align_val_t alignment) { return trackedAlignedNew(size, alignment); }
+void* operator new[](size_t size, std::align_val_t alignment) { return trackedAlignedNew(size, alignment); }
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return trackedAlignedAlloc(size, alignment); }
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return trackedAlignedAlloc(size, alignment); }
+void operator delete(void* ptr, std::align_val_t) noexcept { trackedAlignedFree(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { trackedAlignedFree(ptr); }
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept { trackedAlignedFree(ptr); }
+void operator delete[](void* ptr, size_t, std::align_val_t) noexcept { trackedAlignedFree(ptr); }
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { trackedAlignedFree(ptr); }
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { trackedAlignedFree(ptr); }
+
+bool memoryTrackingEnabled() {
+    return true;
+}
+
+MemoryUsage getMemoryUsage(MemoryCategory category) {
+    size_t index = static_cast<size_t>(category);
+    MemoryUsage usage;
+    usage.bytes = liveBytes[index].load(std::memory_order_relaxed);
+    usage.blocks = liveBlocks[index].load(std::memory_order_relaxed);
+    usage.allocations = totalAllocations[index].load(std::memory_order_relaxed);
+    return usage;
+}
+
+#else
+
+bool memoryTrackingEnabled() {
+    return false;
+}
+
+MemoryUsage getMemoryUsage(MemoryCategory) {
+    return MemoryUsage();
+}
+
+#endif // TRAM_TRACK_MEMORY
+
+const char* getMemoryCategoryName(MemoryCategory category) {
+    switch (category) {
+        case MemoryCategory::NAMES: return "names";
+        case MemoryCategory::ROUTES: return "routes";
+        case MemoryCategory::STOP_TRAMS: return "stop_trams";
+        case MemoryCategory::MAP_NODES: return "map_nodes";
+        case MemoryCategory::INDEXES: return "indexes";
+        default: return "other";
+    }
+}
+
+MemoryCategory currentMemoryCategory() {
+    return currentCategory;
+}
+
+MemoryScope::MemoryScope(MemoryCategory category) : previous(currentCategory) {
+    currentCategory = category;
+}
+
+MemoryScope::~MemoryScope() {
+    currentCategory = previous;
+}
@@ -0,0 +1,109 @@
+#include "network_diff.h"
+#include "parallel.h"
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+// FNV-1a по именам остановок с разделителем, чтобы "AB C" и "A BC" различались
+uint64_t hashRoute(const std::vector<std::string>& stops) {
+    uint64_t h = 1469598103934665603ULL;
+    for (const auto& stop : stops) {
+        for (unsigned char c : stop) {
+            h ^= c;
+            h *= 1099511628211ULL;
+        }
+        h ^= 0xFF;
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+std::vector<uint64_t> hashRoutes(const RouteSet& set) {
+    std::vector<uint64_t> hashes(set.trams.size());
+    parallelFor(set.trams.size(), [&](size_t begin, size_t end, unsigned) {
+        for (size_t i = begin; i < end; ++i) {
+            hashes[i] = hashRoute(set.trams[i].second);
+        }
+    });
+    return hashes;
+}
+
+std::set<std::string> servedStops(const RouteSet& set) {
+    std::set<std::string> result;
+    for (const auto& [tram, stops] : set.trams) {
+        result.insert(stops.begin(), stops.end());
+    }
+    return result;
+}
+
+} // namespace
+
+RouteSet loadRouteSet(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) {
+        throw std::invalid_argument("Cannot open file '" + path + "'");
+    }
+
+    std::map<std::string, std::vector<std::string>> trams; // Повторное описание трамвая заменяет прежнее
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        ++lineNumber;
+        std::istringstream iss(line);
+        std::string tram, stop;
+        if (!(iss >> tram)) continue;
+        if (tram == "CREATE_TRAM" && !(iss >> tram)) continue;
+        std::vector<std::string> stops;
+        while (iss >> stop) {
+            stops.push_back(stop);
+        }
+        // Те же требования к маршруту, что и у CREATE_TRAM, иначе список изменений не выполнится
+        if (stops.size() < 2 || std::adjacent_find(stops.begin(), stops.end()) != stops.end()) {
+            throw std::invalid_argument("'" + path + "' line " + std::to_string(lineNumber) + ": tram " + tram +
+                                        " needs at least 2 stops without consecutive repeats");
+        }
+        trams[tram] = std::move(stops);
+    }
+
+    RouteSet set;
+    set.trams.assign(std::make_move_iterator(trams.begin()), std::make_move_iterator(trams.end()));
+    return set;
+}
+
+NetworkDiff diffNetworks(const RouteSet& before, const RouteSet& after) {
+    std::vector<uint64_t> hashesBefore = hashRoutes(before);
+    std::vector<uint64_t> hashesAfter = hashRoutes(after);
+
+    // Оба набора отсортированы по имени трамвая, поэтому сравнение - один проход слиянием
+    NetworkDiff diff;
+    size_t i = 0, j = 0;
+    while (i < before.trams.size() || j < after.trams.size()) {
+        if (j == after.trams.size() || (i < before.trams.size() && before.trams[i].first < after.trams[j].first)) {
+            diff.removedTrams.push_back(before.trams[i].first);
+            ++i;
+        } else if (i == before.trams.size() || after.trams[j].first < before.trams[i].first) {
+            diff.addedTrams.push_back(after.trams[j]);
+            ++j;
+        } else {
+            if (hashesBefore[i] != hashesAfter[j] || before.trams[i].second != after.trams[j].second) {
+                diff.changedTrams.push_back(after.trams[j]);
+            }
+            ++i;
+            ++j;
+        }
+    }
+
+    std::set<std::string> stopsBefore = servedStops(before);
+    std::set<std::string> stopsAfter = servedStops(after);
+    std::set_difference(stopsAfter.begin(), stopsAfter.end(), stopsBefore.begin(), stopsBefore.end(),
+                        std::back_inserter(diff.addedStops));
+    std::set_difference(stopsBefore.begin(), stopsBefore.end(), stopsAfter.begin(), stopsAfter.end(),
+                        std::back_inserter(diff.lostService));
+    return diff;
+}
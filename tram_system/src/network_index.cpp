@@ -0,0 +1,40 @@
+#include "network_index.h"
+
+int NetworkIndex::tramCount() const {
+    return static_cast<int>(tramNames.size());
+}
+
+int NetworkIndex::stopCount() const {
+    return stopTramStart.empty() ? 0 : static_cast<int>(stopTramStart.size()) - 1;
+}
+
+void NetworkIndex::buildStopTrams(int stopCount) {
+    // Сортировка подсчетом: трамвай попадает в список остановки один раз, даже если проходит ее дважды
+    std::vector<int> lastTram(stopCount, -1);
+    stopTramStart.assign(stopCount + 1, 0);
+    for (int tram = 0; tram < tramCount(); ++tram) {
+        for (int i = tramStopStart[tram]; i < tramStopStart[tram + 1]; ++i) {
+            int stop = tramStops[i];
+            if (lastTram[stop] != tram) {
+                lastTram[stop] = tram;
+                ++stopTramStart[stop + 1];
+            }
+        }
+    }
+    for (int stop = 0; stop < stopCount; ++stop) {
+        stopTramStart[stop + 1] += stopTramStart[stop];
+    }
+
+    stopTrams.assign(stopTramStart[stopCount], 0);
+    std::vector<int> fill(stopTramStart.begin(), stopTramStart.end() - 1);
+    lastTram.assign(stopCount, -1);
+    for (int tram = 0; tram < tramCount(); ++tram) {
+        for (int i = tramStopStart[tram]; i < tramStopStart[tram + 1]; ++i) {
+            int stop = tramStops[i];
+            if (lastTram[stop] != tram) {
+                lastTram[stop] = tram;
+                stopTrams[fill[stop]++] = tram;
+            }
+        }
+    }
+}
@@ -0,0 +1,267 @@
+#include "output_writer.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+bool parseOutputFormat(const std::string& text, OutputFormat& format) {
+    std::string name = text;
+    std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+    if (name == "text") format = OutputFormat::TEXT;
+    else if (name == "json") format = OutputFormat::JSON;
+    else if (name == "binary") format = OutputFormat::BINARY;
+    else return false;
+    return true;
+}
+
+OutputWriter::OutputWriter(std::ostream& out, OutputFormat format) : out(out), format(format) {}
+
+OutputFormat OutputWriter::getFormat() const {
+    return format;
+}
+
+void OutputWriter::setFormat(OutputFormat format) {
+    this->format = format;
+}
+
+void OutputWriter::appendU32(uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        buffer.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+}
+
+void OutputWriter::putU32(size_t pos, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        buffer[pos + i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+    }
+}
+
+void OutputWriter::appendString(std::string_view value) {
+    appendU32(static_cast<uint32_t>(value.size()));
+    buffer.append(value.data(), value.size());
+}
+
+void OutputWriter::appendJsonEscaped(std::string_view value) {
+    for (char c : value) {
+        switch (c) {
+            case '"': buffer.append("\\\""); break;
+            case '\\': buffer.append("\\\\"); break;
+            case '\n': buffer.append("\\n"); break;
+            case '\t': buffer.append("\\t"); break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char escaped[8];
+                    std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                    buffer.append(escaped);
+                } else {
+                    buffer.push_back(c);
+                }
+        }
+    }
+}
+
+void OutputWriter::appendJsonString(std::string_view value) {
+    buffer.push_back('"');
+    appendJsonEscaped(value);
+    buffer.push_back('"');
+}
+
+void OutputWriter::appendJsonKey(std::string_view key) {
+    if (!firstKey) buffer.push_back(',');
+    firstKey = false;
+    appendJsonString(key);
+    buffer.push_back(':');
+}
+
+void OutputWriter::beginElement() {
+    if (!firstElement) buffer.push_back(',');
+    firstElement = false;
+}
+
+void OutputWriter::closeHeader() {
+    if (headerClosed) return;
+    headerClosed = true;
+    if (headerHasContent) buffer.append(": ");
+}
+
+void OutputWriter::beginResponse() {
+    buffer.clear();
+    firstElement = true;
+    if (format == OutputFormat::JSON) buffer.push_back('[');
+    if (format == OutputFormat::BINARY) appendU32(0);
+}
+
+void OutputWriter::endResponse() {
+    if (format == OutputFormat::JSON) buffer.append("]\n");
+    if (format == OutputFormat::BINARY) putU32(0, static_cast<uint32_t>(buffer.size() - 4));
+    out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    out.flush();
+}
+
+void OutputWriter::text(char kind, std::string_view prefix, std::initializer_list<std::string_view> parts) {
+    switch (format) {
+        case OutputFormat::TEXT:
+            buffer.append(prefix.data(), prefix.size());
+            for (std::string_view part : parts) buffer.append(part.data(), part.size());
+            buffer.push_back('\n');
+            break;
+        case OutputFormat::JSON:
+            beginElement();
+            buffer.append(kind == 'E' ? "{\"error\":\"" : "{\"message\":\"");
+            for (std::string_view part : parts) appendJsonEscaped(part);
+            buffer.append("\"}");
+            break;
+        case OutputFormat::BINARY: {
+            buffer.push_back(kind);
+            size_t total = 0;
+            for (std::string_view part : parts) total += part.size();
+            appendU32(static_cast<uint32_t>(total));
+            for (std::string_view part : parts) buffer.append(part.data(), part.size());
+            break;
+        }
+    }
+}
+
+void OutputWriter::message(std::initializer_list<std::string_view> parts) {
+    text('M', {}, parts);
+}
+
+void OutputWriter::error(std::initializer_list<std::string_view> parts) {
+    text('E', "Error: ", parts);
+}
+
+void OutputWriter::beginRecord(std::string_view type) {
+    switch (format) {
+        case OutputFormat::TEXT:
+            buffer.append(type.data(), type.size());
+            headerHasContent = !type.empty();
+            headerClosed = false;
+            bodyHasContent = false;
+            break;
+        case OutputFormat::JSON:
+            beginElement();
+            buffer.push_back('{');
+            firstKey = true;
+            if (!type.empty()) {
+                appendJsonKey("type");
+                appendJsonString(type);
+            }
+            break;
+        case OutputFormat::BINARY:
+            buffer.push_back('R');
+            appendString(type);
+            break;
+    }
+}
+
+void OutputWriter::field(std::string_view key, std::string_view value) {
+    switch (format) {
+        case OutputFormat::TEXT:
+            if (headerHasContent) buffer.push_back(' ');
+            buffer.append(value.data(), value.size());
+            headerHasContent = true;
+            break;
+        case OutputFormat::JSON:
+            appendJsonKey(key);
+            appendJsonString(value);
+            break;
+        case OutputFormat::BINARY:
+            buffer.push_back('S');
+            appendString(key);
+            appendString(value);
+            break;
+    }
+}
+
+void OutputWriter::number(std::string_view key, double value, int precision, std::string_view unit) {
+    char digits[64];
+    int length = std::snprintf(digits, sizeof(digits), "%.*f", precision, value);
+    if (length >= static_cast<int>(sizeof(digits))) { // Очень большие числа - в экспоненциальной записи
+        length = std::snprintf(digits, sizeof(digits), "%.*e", precision, value);
+    }
+    switch (format) {
+        case OutputFormat::TEXT:
+            closeHeader();
+            if (bodyHasContent && buffer.back() != ' ') buffer.push_back(' ');
+            buffer.append(digits, length);
+            buffer.append(unit.data(), unit.size());
+            bodyHasContent = true;
+            break;
+        case OutputFormat::JSON:
+            appendJsonKey(key);
+            if (std::isfinite(value)) {
+                buffer.append(digits, length);
+            } else {
+                buffer.append("null"); // В JSON нет NaN и бесконечностей
+            }
+            break;
+        case OutputFormat::BINARY:
+            buffer.push_back('N');
+            appendString(key);
+            char raw[sizeof(double)];
+            std::memcpy(raw, &value, sizeof(double));
+            buffer.append(raw, sizeof(double));
+            break;
+    }
+}
+
+void OutputWriter::beginList(std::string_view key) {
+    switch (format) {
+        case OutputFormat::TEXT:
+            closeHeader();
+            if (bodyHasContent && buffer.back() != ' ') buffer.push_back(' ');
+            break;
+        case OutputFormat::JSON:
+            appendJsonKey(key);
+            buffer.push_back('[');
+            firstItem = true;
+            break;
+        case OutputFormat::BINARY:
+            buffer.push_back('L');
+            appendString(key);
+            listCountPos = buffer.size();
+            listCount = 0;
+            appendU32(0);
+            break;
+    }
+}
+
+void OutputWriter::item(std::string_view value) {
+    switch (format) {
+        case OutputFormat::TEXT:
+            buffer.append(value.data(), value.size());
+            buffer.push_back(' ');
+            bodyHasContent = true;
+            break;
+        case OutputFormat::JSON:
+            if (!firstItem) buffer.push_back(',');
+            firstItem = false;
+            appendJsonString(value);
+            break;
+        case OutputFormat::BINARY:
+            appendString(value);
+            ++listCount;
+            break;
+    }
+}
+
+void OutputWriter::endList() {
+    if (format == OutputFormat::JSON) buffer.push_back(']');
+    if (format == OutputFormat::BINARY) putU32(listCountPos, listCount);
+}
+
+void OutputWriter::endRecord() {
+    switch (format) {
+        case OutputFormat::TEXT:
+            closeHeader();
+            buffer.push_back('\n');
+            break;
+        case OutputFormat::JSON:
+            buffer.push_back('}');
+            break;
+        case OutputFormat::BINARY:
+            buffer.push_back('Z');
+            break;
+    }
+}
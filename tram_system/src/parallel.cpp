@@ -0,0 +1,41 @@
+#include "parallel.h"
+#include "memory_tracker.h"
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+unsigned workerCount() {
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+void parallelFor(size_t count, const std::function<void(size_t, size_t, unsigned)>& body) {
+    if (count == 0) {
+        return;
+    }
+
+    unsigned workers = static_cast<unsigned>(std::min<size_t>(workerCount(), count));
+    if (workers == 1) {
+        body(0, count, 0);
+        return;
+    }
+
+    // Выделения в рабочих потоках учитываются в той же категории памяти, что и у вызывающего
+    MemoryCategory category = currentMemoryCategory();
+    auto run = [&body, category](size_t begin, size_t end, unsigned worker) {
+        MemoryScope scope(category);
+        body(begin, end, worker);
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(workers);
+    size_t chunk = (count + workers - 1) / workers;
+    for (unsigned w = 0; w < workers; ++w) {
+        size_t begin = w * chunk;
+        size_t end = std::min(count, begin + chunk);
+        if (begin >= end) break;
+        threads.emplace_back(run, begin, end, w);
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
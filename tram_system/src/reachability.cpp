@@ -0,0 +1,98 @@
+#include "reachability.h"
+#include "parallel.h"
+#include <cstdint>
+
+namespace {
+
+// Битовое множество с переиспользованием памяти между запросами
+class Bitset {
+private:
+    std::vector<uint64_t> words;
+
+public:
+    void reset(int size) {
+        words.assign((static_cast<size_t>(size) + 63) / 64, 0);
+    }
+
+    // Возвращает true, если бит был снят и теперь установлен
+    bool insert(int i) {
+        uint64_t mask = uint64_t(1) << (i & 63);
+        uint64_t& word = words[i >> 6];
+        if (word & mask) return false;
+        word |= mask;
+        return true;
+    }
+};
+
+// Буферы одного обхода; в пакетном режиме у каждого потока свои
+struct SearchState {
+    Bitset visitedStops;
+    Bitset usedTrams;
+    std::vector<int> frontier;
+    std::vector<int> next;
+    std::vector<int> reached;
+};
+
+void walkFrom(const FootpathTable& footpaths, SearchState& state, std::vector<int>& stops) {
+    size_t direct = stops.size();
+    for (size_t i = 0; i < direct; ++i) {
+        auto [begin, end] = footpaths.from(stops[i]);
+        for (const Footpath* path = begin; path != end; ++path) {
+            if (state.visitedStops.insert(path->stop)) {
+                stops.push_back(path->stop);
+                state.reached.push_back(path->stop);
+            }
+        }
+    }
+}
+
+void search(const NetworkIndex& network, const FootpathTable& footpaths, int origin, int k, SearchState& state) {
+    state.visitedStops.reset(network.stopCount());
+    state.usedTrams.reset(network.tramCount());
+    state.reached.clear();
+    state.frontier.clear();
+
+    state.visitedStops.insert(origin);
+    state.frontier.push_back(origin);
+    walkFrom(footpaths, state, state.frontier);
+
+    for (int level = 0; level < k && !state.frontier.empty(); ++level) {
+        state.next.clear();
+        for (int stop : state.frontier) {
+            for (int t = network.stopTramStart[stop]; t < network.stopTramStart[stop + 1]; ++t) {
+                int tram = network.stopTrams[t];
+                if (!state.usedTrams.insert(tram)) continue;
+                for (int i = network.tramStopStart[tram]; i < network.tramStopStart[tram + 1]; ++i) {
+                    int other = network.tramStops[i];
+                    if (state.visitedStops.insert(other)) {
+                        state.next.push_back(other);
+                        state.reached.push_back(other);
+                    }
+                }
+            }
+        }
+        walkFrom(footpaths, state, state.next);
+        state.frontier.swap(state.next);
+    }
+}
+
+} // namespace
+
+std::vector<int> reachableStops(const NetworkIndex& network, const FootpathTable& footpaths, int origin, int k) {
+    SearchState state;
+    search(network, footpaths, origin, k, state);
+    return state.reached;
+}
+
+std::vector<int> reachableCounts(const NetworkIndex& network, const FootpathTable& footpaths,
+                                 const std::vector<int>& origins, int k) {
+    std::vector<int> counts(origins.size(), 0);
+    parallelFor(origins.size(), [&](size_t begin, size_t end, unsigned) {
+        SearchState state;
+        for (size_t i = begin; i < end; ++i) {
+            search(network, footpaths, origins[i], k, state);
+            counts[i] = static_cast<int>(state.reached.size());
+        }
+    });
+    return counts;
+}
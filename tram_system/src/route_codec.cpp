@@ -0,0 +1,58 @@
+#include "route_codec.h"
+
+namespace {
+
+// zigzag: небольшие по модулю отрицательные разности тоже дают короткий код
+uint32_t zigzag(int32_t value) {
+    return (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+}
+
+int32_t unzigzag(uint32_t value) {
+    return static_cast<int32_t>(value >> 1) ^ -static_cast<int32_t>(value & 1);
+}
+
+void putVarint(std::vector<uint8_t>& out, uint32_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+} // namespace
+
+std::vector<uint8_t> encodeRoute(const std::vector<int>& stopIds) {
+    std::vector<uint8_t> out;
+    out.reserve(stopIds.size() * 2);
+
+    int previous = 0;
+    for (int id : stopIds) {
+        putVarint(out, zigzag(id - previous));
+        previous = id;
+    }
+
+    out.shrink_to_fit();
+    return out;
+}
+
+std::vector<int> decodeRoute(const std::vector<uint8_t>& data) {
+    std::vector<int> ids;
+    ids.reserve(data.size());
+
+    int previous = 0;
+    uint32_t value = 0;
+    int shift = 0;
+    for (uint8_t byte : data) {
+        value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+        if (byte & 0x80) {
+            shift += 7;
+            continue;
+        }
+        previous += unzigzag(value);
+        ids.push_back(previous);
+        value = 0;
+        shift = 0;
+    }
+
+    return ids;
+}
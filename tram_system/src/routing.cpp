@@ -0,0 +1,310 @@
+#include "routing.h"
+#include "parallel.h"
+#include <algorithm>
+#include <climits>
+#include <queue>
+#include <utility>
+
+namespace {
+
+// Ответвления короче этого считаются в одном потоке: запуск потоков дороже самих поисков
+const size_t PARALLEL_SPUR_THRESHOLD = 16;
+
+// Буферы Дейкстры; вместо очистки массивов используется номер поиска
+struct SearchState {
+    std::vector<int> dist;
+    std::vector<int> prev;
+    std::vector<unsigned> visitedIn; // Номер поиска, в котором вершина получила dist
+    std::vector<unsigned> blockedIn; // Номер поиска, в котором остановка запрещена
+    unsigned search = 0;
+    std::priority_queue<std::pair<int, int>, std::vector<std::pair<int, int>>, std::greater<>> queue;
+
+    void prepare(const StopGraph& graph) {
+        if (static_cast<int>(dist.size()) != graph.nodeCount()) {
+            dist.assign(graph.nodeCount(), 0);
+            prev.assign(graph.nodeCount(), -1);
+            visitedIn.assign(graph.nodeCount(), 0);
+            blockedIn.assign(graph.stopCount(), 0);
+            search = 0;
+        }
+        ++search;
+        queue = {};
+    }
+};
+
+// Дейкстра от вершины from до любой вершины-остановки to с запрещенными остановками
+// (отмечены в state.blockedIn) и запрещенными ребрами из from в blockedNext
+bool shortestPath(const StopGraph& graph, int from, int to, const std::vector<int>& blockedNext,
+                  SearchState& state, StopPath& path) {
+    state.dist[from] = 0;
+    state.prev[from] = -1;
+    state.visitedIn[from] = state.search;
+    state.queue.emplace(0, from);
+
+    int target = -1;
+    while (!state.queue.empty()) {
+        auto [d, v] = state.queue.top();
+        state.queue.pop();
+        if (d > state.dist[v]) continue;
+        if (graph.isStopNode(v) && graph.stopOf(v) == to) {
+            target = v;
+            break;
+        }
+
+        // Трамвай, из которого только что вышли: снова сесть в него - тот же путь, только с пересадкой
+        int leftTram = graph.isStopNode(v) && state.prev[v] >= 0 && !graph.isStopNode(state.prev[v])
+                           ? graph.rideTram[state.prev[v] - 2 * graph.stops] : -1;
+        for (int e = graph.start[v]; e < graph.start[v + 1]; ++e) {
+            int w = graph.edges[e].to;
+            if (state.blockedIn[graph.stopOf(w)] == state.search) continue;
+            if (v == from && std::find(blockedNext.begin(), blockedNext.end(), w) != blockedNext.end()) continue;
+            if (graph.edges[e].kind == EdgeKind::BOARD && graph.rideTram[w - 2 * graph.stops] == leftTram) continue;
+            int nd = d + graph.edges[e].seconds;
+            if (state.visitedIn[w] != state.search || nd < state.dist[w]) {
+                state.visitedIn[w] = state.search;
+                state.dist[w] = nd;
+                state.prev[w] = v;
+                state.queue.emplace(nd, w);
+            }
+        }
+    }
+
+    if (target < 0) {
+        return false;
+    }
+    path.seconds = state.dist[target];
+    path.nodes.clear();
+    for (int v = target; v != -1; v = state.prev[v]) {
+        path.nodes.push_back(v);
+    }
+    std::reverse(path.nodes.begin(), path.nodes.end());
+    return true;
+}
+
+// Остановки и участки пути по видам его ребер: участок трамвая идет от посадки до высадки
+void describePath(const StopGraph& graph, StopPath& path) {
+    path.stops.assign(1, graph.stopOf(path.nodes[0]));
+    path.legs.clear();
+    size_t rideFrom = 0;
+    for (size_t i = 1; i < path.nodes.size(); ++i) {
+        const GraphEdge* edge = graph.findEdge(path.nodes[i - 1], path.nodes[i]);
+        switch (edge->kind) {
+        case EdgeKind::BOARD:
+            rideFrom = path.stops.size() - 1;
+            path.stops.push_back(graph.stopOf(path.nodes[i]));
+            break;
+        case EdgeKind::RIDE:
+            path.stops.push_back(graph.stopOf(path.nodes[i]));
+            break;
+        case EdgeKind::ALIGHT:
+            path.legs.push_back({graph.rideTram[path.nodes[i - 1] - 2 * graph.stops], rideFrom, path.stops.size() - 1});
+            break;
+        case EdgeKind::WALK:
+            path.stops.push_back(graph.stopOf(path.nodes[i]));
+            path.legs.push_back({-1, path.stops.size() - 2, path.stops.size() - 1});
+            break;
+        }
+    }
+}
+
+// Путь проходит остановку дважды или выходит из трамвая, чтобы тут же сесть в него снова
+bool isRedundant(const StopPath& path) {
+    for (size_t i = 1; i < path.legs.size(); ++i) {
+        if (path.legs[i].tram >= 0 && path.legs[i].tram == path.legs[i - 1].tram) return true;
+    }
+    std::vector<int> stops = path.stops;
+    std::sort(stops.begin(), stops.end());
+    return std::adjacent_find(stops.begin(), stops.end()) != stops.end();
+}
+
+// Ответвление от i-й вершины последнего найденного пути
+bool spurPath(const StopGraph& graph, const std::vector<StopPath>& found, size_t i, int to,
+              SearchState& state, StopPath& candidate) {
+    const StopPath& last = found.back();
+    state.prepare(graph);
+
+    // Ребра, по которым уже уходили найденные пути с тем же корнем
+    std::vector<int> blockedNext;
+    for (const StopPath& path : found) {
+        if (path.nodes.size() > i + 1 && std::equal(last.nodes.begin(), last.nodes.begin() + i + 1, path.nodes.begin())) {
+            blockedNext.push_back(path.nodes[i + 1]);
+        }
+    }
+    // Остановки корня, кроме точки ответвления, чтобы путь остался без циклов
+    int spurStop = graph.stopOf(last.nodes[i]);
+    for (size_t r = 0; r < i; ++r) {
+        int stop = graph.stopOf(last.nodes[r]);
+        if (stop != spurStop) state.blockedIn[stop] = state.search;
+    }
+
+    StopPath spur;
+    if (!shortestPath(graph, last.nodes[i], to, blockedNext, state, spur)) {
+        return false;
+    }
+
+    candidate.nodes.assign(last.nodes.begin(), last.nodes.begin() + i);
+    candidate.nodes.insert(candidate.nodes.end(), spur.nodes.begin(), spur.nodes.end());
+    candidate.seconds = spur.seconds;
+    for (size_t r = 0; r < i; ++r) {
+        candidate.seconds += graph.findEdge(last.nodes[r], last.nodes[r + 1])->seconds;
+    }
+    describePath(graph, candidate);
+    // Запреты стоят на остановках, но вершин у остановки несколько: вернуться на нее можно другим трамваем
+    return !isRedundant(candidate);
+}
+
+} // namespace
+
+void StopGraph::build(const NetworkIndex& network, const FootpathTable& footpaths, int rideSeconds, int transferSeconds) {
+    stops = network.stopCount();
+    rideStop = network.tramStops;
+    rideTram.assign(rideStop.size(), 0);
+    std::vector<std::vector<GraphEdge>> lists(2 * stops + rideStop.size());
+    for (int tram = 0; tram < network.tramCount(); ++tram) {
+        for (int j = network.tramStopStart[tram]; j < network.tramStopStart[tram + 1]; ++j) {
+            int ride = 2 * stops + j;
+            rideTram[j] = tram;
+            lists[ride].push_back({rideStop[j], 0, EdgeKind::ALIGHT});
+            if (j == network.tramStopStart[tram]) continue;
+            // Посадка сразу включает первый перегон, чтобы у участка трамвая не было нулевой длины
+            int a = rideStop[j - 1];
+            int b = rideStop[j];
+            lists[freshNode(a)].push_back({ride, rideSeconds, EdgeKind::BOARD});
+            lists[a].push_back({ride, rideSeconds + transferSeconds, EdgeKind::BOARD});
+            lists[freshNode(b)].push_back({ride - 1, rideSeconds, EdgeKind::BOARD});
+            lists[b].push_back({ride - 1, rideSeconds + transferSeconds, EdgeKind::BOARD});
+            lists[ride - 1].push_back({ride, rideSeconds, EdgeKind::RIDE});
+            lists[ride].push_back({ride - 1, rideSeconds, EdgeKind::RIDE});
+        }
+    }
+    for (int stop = 0; stop < stops; ++stop) {
+        auto [begin, end] = footpaths.from(stop);
+        for (const Footpath* path = begin; path != end; ++path) {
+            if (path->stop >= stops) continue;
+            lists[stop].push_back({path->stop, path->seconds, EdgeKind::WALK});
+            lists[freshNode(stop)].push_back({freshNode(path->stop), path->seconds, EdgeKind::WALK});
+        }
+    }
+
+    start.assign(lists.size() + 1, 0);
+    edges.clear();
+    for (size_t node = 0; node < lists.size(); ++node) {
+        auto& list = lists[node];
+        std::sort(list.begin(), list.end(), [](const GraphEdge& x, const GraphEdge& y) {
+            return x.to != y.to ? x.to < y.to : x.seconds < y.seconds;
+        });
+        for (size_t i = 0; i < list.size(); ++i) {
+            if (i == 0 || list[i].to != list[i - 1].to) edges.push_back(list[i]);
+        }
+        start[node + 1] = static_cast<int>(edges.size());
+    }
+}
+
+int StopGraph::stopCount() const {
+    return stops;
+}
+
+int StopGraph::nodeCount() const {
+    return start.empty() ? 0 : static_cast<int>(start.size()) - 1;
+}
+
+int StopGraph::freshNode(int stop) const {
+    return stops + stop;
+}
+
+bool StopGraph::isStopNode(int node) const {
+    return node < 2 * stops;
+}
+
+int StopGraph::stopOf(int node) const {
+    if (node < stops) return node;
+    if (node < 2 * stops) return node - stops;
+    return rideStop[node - 2 * stops];
+}
+
+const GraphEdge* StopGraph::findEdge(int from, int to) const {
+    for (int e = start[from]; e < start[from + 1]; ++e) {
+        if (edges[e].to == to) return &edges[e];
+    }
+    return nullptr;
+}
+
+std::vector<StopPath> kShortestPaths(const StopGraph& graph, int from, int to, int k) {
+    std::vector<StopPath> found;
+    if (k <= 0 || from == to) {
+        return found;
+    }
+
+    std::vector<SearchState> states(workerCount()); // Свои буферы у каждого потока на весь запрос
+    states[0].prepare(graph);
+    StopPath first;
+    if (!shortestPath(graph, graph.freshNode(from), to, {}, states[0], first)) {
+        return found;
+    }
+    describePath(graph, first);
+    found.push_back(std::move(first));
+
+    std::vector<StopPath> candidates;
+    while (static_cast<int>(found.size()) < k) {
+        size_t spurCount = found.back().nodes.size() - 1;
+        std::vector<StopPath> spurs(spurCount);
+        std::vector<char> ok(spurCount, 0);
+        auto runSpurs = [&](size_t begin, size_t end, unsigned worker) {
+            for (size_t i = begin; i < end; ++i) {
+                ok[i] = spurPath(graph, found, i, to, states[worker], spurs[i]);
+            }
+        };
+        if (spurCount >= PARALLEL_SPUR_THRESHOLD) {
+            parallelFor(spurCount, runSpurs);
+        } else {
+            runSpurs(0, spurCount, 0);
+        }
+
+        for (size_t i = 0; i < spurCount; ++i) {
+            if (!ok[i]) continue;
+            bool duplicate = false;
+            for (const StopPath& path : candidates) {
+                if (path.nodes == spurs[i].nodes) { duplicate = true; break; }
+            }
+            for (const StopPath& path : found) {
+                if (path.nodes == spurs[i].nodes) { duplicate = true; break; }
+            }
+            if (!duplicate) candidates.push_back(std::move(spurs[i]));
+        }
+        if (candidates.empty()) {
+            break;
+        }
+
+        auto best = std::min_element(candidates.begin(), candidates.end(), [](const StopPath& x, const StopPath& y) {
+            return x.seconds != y.seconds ? x.seconds < y.seconds : x.stops.size() < y.stops.size();
+        });
+        found.push_back(std::move(*best));
+        candidates.erase(best);
+    }
+    return found;
+}
+
+void shortestPathTree(const StopGraph& graph, int from, std::vector<int>& prev, std::vector<int>& order) {
+    std::vector<int> dist(graph.nodeCount(), INT_MAX);
+    prev.assign(graph.nodeCount(), -1);
+    order.clear();
+    std::priority_queue<std::pair<int, int>, std::vector<std::pair<int, int>>, std::greater<>> queue;
+    dist[from] = 0;
+    queue.emplace(0, from);
+
+    while (!queue.empty()) {
+        auto [d, v] = queue.top();
+        queue.pop();
+        if (d > dist[v]) continue;
+        order.push_back(v);
+        for (int e = graph.start[v]; e < graph.start[v + 1]; ++e) {
+            int w = graph.edges[e].to;
+            int nd = d + graph.edges[e].seconds;
+            if (nd < dist[w]) {
+                dist[w] = nd;
+                prev[w] = v;
+                queue.emplace(nd, w);
+            }
+        }
+    }
+}
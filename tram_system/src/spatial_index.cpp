@@ -0,0 +1,165 @@
+#include "spatial_index.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+const double EARTH_RADIUS = 6371000.0; // Радиус Земли в метрах
+const double DEG_TO_RAD = 3.14159265358979323846 / 180.0;
+const int POINTS_PER_CELL = 2; // Целевое среднее количество остановок в ячейке
+
+} // namespace
+
+void SpatialIndex::project(double lat, double lon, double& x, double& y) const {
+    x = lon * DEG_TO_RAD * cosOriginLat * EARTH_RADIUS;
+    y = lat * DEG_TO_RAD * EARTH_RADIUS;
+}
+
+int SpatialIndex::cellOf(double x, double y, int& cx, int& cy) const {
+    cx = static_cast<int>(std::clamp((x - minX) / cellSize, 0.0, static_cast<double>(cols - 1)));
+    cy = static_cast<int>(std::clamp((y - minY) / cellSize, 0.0, static_cast<double>(rows - 1)));
+    return cy * cols + cx;
+}
+
+void SpatialIndex::build(const std::vector<int>& stopIds, const std::vector<double>& lats, const std::vector<double>& lons) {
+    size_t n = stopIds.size();
+    ids.assign(n, 0);
+    xs.assign(n, 0.0);
+    ys.assign(n, 0.0);
+    if (n == 0) {
+        cols = rows = 0;
+        cellStart.clear();
+        return;
+    }
+
+    originLat = 0.0;
+    for (double lat : lats) originLat += lat;
+    originLat /= static_cast<double>(n);
+    cosOriginLat = std::cos(originLat * DEG_TO_RAD);
+
+    std::vector<double> px(n), py(n);
+    double maxX, maxY;
+    for (size_t i = 0; i < n; ++i) {
+        project(lats[i], lons[i], px[i], py[i]);
+    }
+    minX = maxX = px[0];
+    minY = maxY = py[0];
+    for (size_t i = 1; i < n; ++i) {
+        minX = std::min(minX, px[i]);
+        maxX = std::max(maxX, px[i]);
+        minY = std::min(minY, py[i]);
+        maxY = std::max(maxY, py[i]);
+    }
+
+    // Размер ячейки подбирается так, чтобы в среднем в ней было POINTS_PER_CELL остановок
+    double width = std::max(maxX - minX, 1.0);
+    double height = std::max(maxY - minY, 1.0);
+    double targetCells = std::max(1.0, static_cast<double>(n) / POINTS_PER_CELL);
+    cellSize = std::max(std::sqrt(width * height / targetCells), 1.0);
+    cols = static_cast<int>(width / cellSize) + 1;
+    rows = static_cast<int>(height / cellSize) + 1;
+
+    // Сортировка подсчетом по номеру ячейки
+    std::vector<int> cellIndex(n);
+    cellStart.assign(static_cast<size_t>(cols) * rows + 1, 0);
+    for (size_t i = 0; i < n; ++i) {
+        int cx, cy;
+        cellIndex[i] = cellOf(px[i], py[i], cx, cy);
+        ++cellStart[cellIndex[i] + 1];
+    }
+    for (size_t c = 1; c < cellStart.size(); ++c) {
+        cellStart[c] += cellStart[c - 1];
+    }
+    std::vector<int> fill(cellStart.begin(), cellStart.end() - 1);
+    for (size_t i = 0; i < n; ++i) {
+        int pos = fill[cellIndex[i]]++;
+        ids[pos] = stopIds[i];
+        xs[pos] = px[i];
+        ys[pos] = py[i];
+    }
+}
+
+bool SpatialIndex::empty() const {
+    return ids.empty();
+}
+
+std::vector<std::pair<int, double>> SpatialIndex::nearest(double lat, double lon, int k) const {
+    std::vector<std::pair<int, double>> result;
+    if (empty() || k <= 0) {
+        return result;
+    }
+
+    double x, y;
+    project(lat, lon, x, y);
+    int cx, cy;
+    cellOf(x, y, cx, cy);
+
+    // Обходим кольца ячеек вокруг точки запроса, пока k-й найденный кандидат
+    // не окажется ближе, чем любая точка следующего кольца
+    std::vector<std::pair<double, int>> candidates; // (квадрат расстояния, ID)
+    size_t want = std::min(static_cast<size_t>(k), ids.size());
+    int maxRing = std::max(cols, rows);
+    for (int ring = 0; ring <= maxRing; ++ring) {
+        for (int gy = cy - ring; gy <= cy + ring; ++gy) {
+            if (gy < 0 || gy >= rows) continue;
+            bool edgeRow = (gy == cy - ring || gy == cy + ring);
+            for (int gx = cx - ring; gx <= cx + ring; gx += (edgeRow ? 1 : 2 * ring)) {
+                if (gx >= 0 && gx < cols) {
+                    int cell = gy * cols + gx;
+                    for (int i = cellStart[cell]; i < cellStart[cell + 1]; ++i) {
+                        double dx = xs[i] - x, dy = ys[i] - y;
+                        candidates.emplace_back(dx * dx + dy * dy, ids[i]);
+                    }
+                }
+                if (ring == 0) break;
+            }
+        }
+
+        if (candidates.size() >= want) {
+            std::nth_element(candidates.begin(), candidates.begin() + (want - 1), candidates.end());
+            double reach = ring * cellSize; // Все непросмотренные точки не ближе этого расстояния
+            if (candidates[want - 1].first <= reach * reach || candidates.size() == ids.size()) {
+                break;
+            }
+        }
+    }
+
+    std::sort(candidates.begin(), candidates.end());
+    candidates.resize(want);
+    for (const auto& [dist2, id] : candidates) {
+        result.emplace_back(id, std::sqrt(dist2));
+    }
+    return result;
+}
+
+std::vector<std::pair<int, double>> SpatialIndex::withinRadius(double lat, double lon, double radius) const {
+    std::vector<std::pair<int, double>> result;
+    if (empty() || radius < 0) {
+        return result;
+    }
+
+    double x, y;
+    project(lat, lon, x, y);
+    int fromX, fromY, toX, toY;
+    cellOf(x - radius, y - radius, fromX, fromY);
+    cellOf(x + radius, y + radius, toX, toY);
+
+    double radius2 = radius * radius;
+    for (int gy = fromY; gy <= toY; ++gy) {
+        for (int gx = fromX; gx <= toX; ++gx) {
+            int cell = gy * cols + gx;
+            for (int i = cellStart[cell]; i < cellStart[cell + 1]; ++i) {
+                double dx = xs[i] - x, dy = ys[i] - y;
+                double dist2 = dx * dx + dy * dy;
+                if (dist2 <= radius2) {
+                    result.emplace_back(ids[i], std::sqrt(dist2));
+                }
+            }
+        }
+    }
+
+    std::sort(result.begin(), result.end(), [](const auto& a, const auto& b) {
+        return a.second < b.second;
+    });
+    return result;
+}
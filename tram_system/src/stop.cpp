@@ -1,15 +1,42 @@
 #include "stop.h"
+#include <algorithm>
 
-Stop::Stop(const std::string& name) : name(name) {}
+Stop::Stop(const std::string& name, int id) : name(name), id(id) {}
 
 const std::string& Stop::getName() const {
     return name;
 }
 
+int Stop::getId() const {
+    return id;
+}
+
 const std::vector<std::string>& Stop::getTrams() const {
     return trams;
 }
 
+bool Stop::hasCoordinates() const {
+    return hasCoords;
+}
+
+double Stop::getLat() const {
+    return lat;
+}
+
+double Stop::getLon() const {
+    return lon;
+}
+
 void Stop::addTram(const std::string& tram) {
     trams.push_back(tram);
-}
\ No newline at end of file
+}
+
+void Stop::removeTram(const std::string& tram) {
+    trams.erase(std::remove(trams.begin(), trams.end(), tram), trams.end());
+}
+
+void Stop::setCoordinates(double lat, double lon) {
+    this->lat = lat;
+    this->lon = lon;
+    hasCoords = true;
+}
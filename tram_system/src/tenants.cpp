@@ -0,0 +1,91 @@
+#include "tenants.h"
+#include <stdexcept>
+
+Tenants::Tenants(bool compactRoutes) : compactRoutes(compactRoutes) {
+    use(DEFAULT_TENANT);
+}
+
+Tenants::~Tenants() {
+    {
+        std::lock_guard<std::mutex> lock(reclaimMutex);
+        stopping = true;
+    }
+    reclaimReady.notify_one();
+    if (reclaimer.joinable()) {
+        reclaimer.join();
+    }
+}
+
+void Tenants::reclaim() {
+    std::unique_lock<std::mutex> lock(reclaimMutex);
+    while (true) {
+        reclaimReady.wait(lock, [this] { return stopping || !reclaimQueue.empty(); });
+        if (reclaimQueue.empty()) return; // stopping и освобождать больше нечего
+
+        std::vector<std::unique_ptr<TramSystem>> doomed;
+        doomed.swap(reclaimQueue);
+        lock.unlock();
+        doomed.clear();
+        lock.lock();
+    }
+}
+
+TramSystem& Tenants::current() {
+    return *tenants.at(currentName).system;
+}
+
+const std::string& Tenants::getCurrentName() const {
+    return currentName;
+}
+
+void Tenants::countQuery() {
+    ++tenants.at(currentName).queries;
+}
+
+bool Tenants::use(const std::string& name) {
+    auto it = tenants.find(name);
+    bool created = false;
+    if (it == tenants.end()) {
+        tenants[name].system = std::make_unique<TramSystem>(compactRoutes);
+        created = true;
+    }
+    currentName = name;
+    return created;
+}
+
+void Tenants::drop(const std::string& name) {
+    auto it = tenants.find(name);
+    if (it == tenants.end()) {
+        throw std::invalid_argument("City '" + name + "' does not exist");
+    }
+    if (name == currentName) {
+        throw std::invalid_argument("Cannot drop the city in use");
+    }
+
+    // Город отсоединяется за O(1), а освобождение всех его узлов идет в фоновом потоке,
+    // чтобы большой город не задерживал следующую команду
+    std::unique_ptr<TramSystem> system = std::move(it->second.system);
+    tenants.erase(it);
+    {
+        std::lock_guard<std::mutex> lock(reclaimMutex);
+        reclaimQueue.push_back(std::move(system));
+    }
+    reclaimReady.notify_one();
+    if (!reclaimer.joinable()) {
+        reclaimer = std::thread(&Tenants::reclaim, this);
+    }
+}
+
+std::vector<TenantStats> Tenants::getStats() const {
+    std::vector<TenantStats> result;
+    for (const auto& [name, tenant] : tenants) {
+        TenantStats stats;
+        stats.name = name;
+        stats.trams = tenant.system->getTrams().size();
+        stats.stops = tenant.system->getStopCount();
+        stats.memoryBytes = tenant.system->estimateMemory();
+        stats.queries = tenant.queries;
+        result.push_back(stats);
+    }
+    return result;
+}
@@ -0,0 +1,134 @@
+#include "trace.h"
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+std::atomic<bool> traceEnabledFlag{false};
+
+namespace {
+
+const size_t BUFFER_CAPACITY = 1 << 14; // Событий на поток; лишние отбрасываются и считаются
+const size_t DETAIL_SIZE = 32;
+
+struct TraceEvent {
+    const char* name;
+    char detail[DETAIL_SIZE]; // Копия, чтобы не выделять память на каждое событие
+    uint64_t start;
+    uint64_t duration;
+};
+
+// Буфер пишет только его поток; count публикуется с release, поэтому выгрузка видит готовые события
+struct ThreadBuffer {
+    uint32_t tid;
+    std::unique_ptr<TraceEvent[]> events{new TraceEvent[BUFFER_CAPACITY]};
+    std::atomic<size_t> count{0};
+    std::atomic<size_t> dropped{0};
+};
+
+const auto startTime = std::chrono::steady_clock::now();
+
+// Реестр буферов нужен только для регистрации потока и выгрузки; буферы живут до конца программы,
+// так что события завершившихся потоков не теряются
+std::mutex registryMutex;
+std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+thread_local ThreadBuffer* localBuffer = nullptr;
+
+ThreadBuffer* threadBuffer() {
+    if (!localBuffer) {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        buffers.push_back(std::make_unique<ThreadBuffer>());
+        buffers.back()->tid = static_cast<uint32_t>(buffers.size());
+        localBuffer = buffers.back().get();
+    }
+    return localBuffer;
+}
+
+void writeJsonString(std::ofstream& file, const char* text) {
+    file << '"';
+    for (const char* c = text; *c; ++c) {
+        if (*c == '"' || *c == '\\') {
+            file << '\\' << *c;
+        } else if (static_cast<unsigned char>(*c) < 0x20) {
+            file << ' ';
+        } else {
+            file << *c;
+        }
+    }
+    file << '"';
+}
+
+} // namespace
+
+void setTraceEnabled(bool enabled) {
+    if (enabled) {
+        // Очистка безопасна, пока другие потоки не пишут события (команды выполняются по одной)
+        std::lock_guard<std::mutex> lock(registryMutex);
+        for (auto& buffer : buffers) {
+            buffer->count.store(0, std::memory_order_relaxed);
+            buffer->dropped.store(0, std::memory_order_relaxed);
+        }
+    }
+    traceEnabledFlag.store(enabled, std::memory_order_relaxed);
+}
+
+uint64_t traceNow() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - startTime).count());
+}
+
+void recordTraceEvent(const char* name, std::string_view detail, uint64_t start, uint64_t end) {
+    ThreadBuffer* buffer = threadBuffer();
+    size_t index = buffer->count.load(std::memory_order_relaxed);
+    if (index >= BUFFER_CAPACITY) {
+        buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    TraceEvent& event = buffer->events[index];
+    event.name = name;
+    size_t length = detail.copy(event.detail, DETAIL_SIZE - 1);
+    if (length < detail.size()) {
+        // Обрезка по границе символа UTF-8: байты продолжения (10xxxxxx) не могут начинать символ
+        while (length > 0 && (static_cast<unsigned char>(detail[length]) & 0xC0) == 0x80) --length;
+    }
+    event.detail[length] = '\0';
+    event.start = start;
+    event.duration = end - start;
+    buffer->count.store(index + 1, std::memory_order_release);
+}
+
+size_t writeTrace(const std::string& path, size_t& dropped) {
+    std::ofstream file(path);
+    if (!file) {
+        throw std::invalid_argument("Cannot open file '" + path + "'");
+    }
+
+    size_t written = 0;
+    dropped = 0;
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    std::lock_guard<std::mutex> lock(registryMutex);
+    for (const auto& buffer : buffers) {
+        size_t count = buffer->count.load(std::memory_order_acquire);
+        dropped += buffer->dropped.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < count; ++i) {
+            const TraceEvent& event = buffer->events[i];
+            file << (written++ ? ",\n" : "\n") << "{\"name\":";
+            writeJsonString(file, event.name);
+            file << ",\"cat\":\"tram_system\",\"ph\":\"X\",\"ts\":" << event.start << ",\"dur\":" << event.duration
+                 << ",\"pid\":1,\"tid\":" << buffer->tid;
+            if (event.detail[0]) {
+                file << ",\"args\":{\"detail\":";
+                writeJsonString(file, event.detail);
+                file << "}";
+            }
+            file << "}";
+        }
+    }
+    file << "\n]}\n";
+    if (!file) {
+        throw std::invalid_argument("Cannot write file '" + path + "'");
+    }
+    return written;
+}
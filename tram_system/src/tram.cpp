@@ -1,21 +1,46 @@
 #include "tram.h"
 
+namespace {
+
+const std::vector<std::string> NO_STOPS;
+const std::vector<uint8_t> NO_ENCODED_STOPS;
+
+} // namespace
+
 Tram::Tram(const std::string& name, const std::vector<std::string>& stops)
-    : name(name), stops(stops) {}
+    : name(name), stops(std::make_shared<const std::vector<std::string>>(stops)) {}
+
+Tram::Tram(const std::string& name, std::shared_ptr<const std::vector<std::string>> stops)
+    : name(name), stops(std::move(stops)) {}
+
+Tram::Tram(const std::string& name, std::shared_ptr<const std::vector<uint8_t>> encodedStops)
+    : name(name), encodedStops(std::move(encodedStops)) {}
 
 const std::string& Tram::getName() const {
     return name;
 }
 
 const std::vector<std::string>& Tram::getStops() const {
-    return stops;
+    return stops ? *stops : NO_STOPS;
+}
+
+const std::vector<uint8_t>& Tram::getEncodedStops() const {
+    return encodedStops ? *encodedStops : NO_ENCODED_STOPS;
+}
+
+bool Tram::isCompact() const {
+    return encodedStops != nullptr;
+}
+
+const void* Tram::getRouteStorage() const {
+    return isCompact() ? static_cast<const void*>(encodedStops.get()) : static_cast<const void*>(stops.get());
 }
 
 bool Tram::passesThrough(const std::string& stop) const {
-    for (const auto& s : stops) {
+    for (const auto& s : getStops()) {
         if (s == stop) {
             return true;
         }
     }
     return false;
-}
\ No newline at end of file
+}
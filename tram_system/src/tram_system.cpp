@@ -1,5 +1,76 @@
 #include "tram_system.h"
+#include "route_codec.h"
+#include "analytics.h"
+#include "reachability.h"
+#include "memory_tracker.h"
+#include "trace.h"
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <iterator>
+#include <string_view>
 #include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <unordered_set>
+
+namespace {
+
+const size_t MAP_NODE_OVERHEAD = 32; // Цвет и три указателя узла красно-черного дерева
+
+// Память строки вне объекта (короткие строки хранятся внутри std::string)
+size_t stringHeapBytes(const std::string& s) {
+    return s.capacity() >= sizeof(std::string) ? s.capacity() + 1 : 0;
+}
+
+// Полиномиальный хэш последовательности ID остановок
+uint64_t hashRoute(const std::vector<int>& stopIds) {
+    uint64_t hash = 0;
+    for (int id : stopIds) {
+        hash = hash * 1000003 + static_cast<uint64_t>(id) + 1;
+    }
+    return hash;
+}
+
+// Возвращает уже сохраненную копию маршрута или сохраняет новый
+template <typename Route>
+std::shared_ptr<const Route> internRoute(std::unordered_map<uint64_t, std::vector<std::shared_ptr<const Route>>>& pool,
+                                         uint64_t hash, Route&& route) {
+    auto& bucket = pool[hash];
+    for (const auto& stored : bucket) {
+        if (*stored == route) {
+            return stored;
+        }
+    }
+    bucket.push_back(std::make_shared<const Route>(std::move(route)));
+    return bucket.back();
+}
+
+// Убирает из пула маршруты, которыми больше не пользуется ни один трамвай
+template <typename Route>
+void releaseRoutes(std::unordered_map<uint64_t, std::vector<std::shared_ptr<const Route>>>& pool, uint64_t hash) {
+    auto it = pool.find(hash);
+    if (it == pool.end()) {
+        return;
+    }
+    auto& bucket = it->second;
+    bucket.erase(std::remove_if(bucket.begin(), bucket.end(), [](const auto& stored) { return stored.use_count() == 1; }),
+                 bucket.end());
+    if (bucket.empty()) {
+        pool.erase(it);
+    }
+}
+
+template <typename T>
+size_t vectorHeapBytes(const std::vector<T>& v) {
+    return v.capacity() * sizeof(T);
+}
+
+} // namespace
+
+TramSystem::TramSystem(bool compactRoutes) : compactRoutes(compactRoutes) {
+    rebuildFilters();
+}
 
 void TramSystem::createTram(const std::string& tramName, const std::vector<std::string>& stopNames) {
     // Проверка на минимальное количество остановок
@@ -17,23 +88,331 @@ void TramSystem::createTram(const std::string& tramName, const std::vector<std::
         throw std::invalid_argument("Consecutive stops cannot be identical");
     }
 
-    // Создаем трамвай
-    trams.emplace(tramName, Tram(tramName, stopNames));
-    
+    int firstNewId = 0;
+    std::vector<int> stopIds = attachTram(tramName, stopNames, firstNewId);
+    publishRouteChange(tramName, {}, stopIds, firstNewId);
+}
+
+void TramSystem::removeTram(const std::string& tramName) {
+    auto it = trams.find(tramName);
+    if (it == trams.end()) {
+        throw std::invalid_argument("Tram '" + tramName + "' does not exist");
+    }
+    std::vector<int> stopIds = detachTram(it);
+    publishRouteChange(tramName, stopIds, {}, static_cast<int>(stopById.size()));
+}
+
+void TramSystem::changeTram(const std::string& tramName, const std::vector<std::string>& stopNames) {
+    auto it = trams.find(tramName);
+    if (it == trams.end()) {
+        throw std::invalid_argument("Tram '" + tramName + "' does not exist");
+    }
+    // Новый маршрут проверяется до удаления старого, чтобы ошибка не оставила сеть без трамвая
+    if (stopNames.size() < 2) {
+        throw std::invalid_argument("Tram must have at least 2 stops");
+    }
+    if (std::adjacent_find(stopNames.begin(), stopNames.end()) != stopNames.end()) {
+        throw std::invalid_argument("Consecutive stops cannot be identical");
+    }
+    std::vector<int> oldStopIds = detachTram(it);
+    int firstNewId = 0;
+    std::vector<int> stopIds = attachTram(tramName, stopNames, firstNewId);
+    publishRouteChange(tramName, oldStopIds, stopIds, firstNewId);
+}
+
+std::vector<int> TramSystem::attachTram(const std::string& tramName, const std::vector<std::string>& stopNames, int& firstNewId) {
     // Обновляем информацию об остановках
+    std::vector<int> stopIds;
+    stopIds.reserve(stopNames.size());
+    firstNewId = static_cast<int>(stopById.size());
     for (const auto& stopName : stopNames) {
         auto it = stops.find(stopName);
         if (it == stops.end()) {
-            stops.emplace(stopName, Stop(stopName));
-            stops.at(stopName).addTram(tramName);
+            // Имена, узел словаря и индексы создаются по отдельности, чтобы учет памяти разнес их по категориям
+            int id = static_cast<int>(stopById.size());
+            std::string key;
+            Stop stop;
+            {
+                MemoryScope scope(MemoryCategory::NAMES);
+                key = stopName;
+                stop = Stop(stopName, id);
+            }
+            {
+                MemoryScope scope(MemoryCategory::MAP_NODES);
+                it = stops.emplace(std::move(key), std::move(stop)).first;
+            }
+            MemoryScope scope(MemoryCategory::INDEXES);
+            connectivity.add();
+            stopById.push_back(&it->second);
+        }
+        MemoryScope scope(MemoryCategory::STOP_TRAMS);
+        it->second.addTram(tramName);
+        stopIds.push_back(it->second.getId());
+    }
+
+    // Все остановки маршрута попадают в одну компоненту связности
+    for (size_t i = 1; i < stopIds.size(); ++i) {
+        connectivity.unite(stopIds[0], stopIds[i]);
+    }
+
+    // Создаем трамвай; трамваи с одинаковой последовательностью остановок делят один маршрут
+    uint64_t hash = hashRoute(stopIds);
+    std::shared_ptr<const std::vector<uint8_t>> encodedRoute;
+    std::shared_ptr<const std::vector<std::string>> route;
+    {
+        MemoryScope scope(MemoryCategory::ROUTES);
+        if (compactRoutes) {
+            encodedRoute = internRoute(sharedEncodedRoutes, hash, encodeRoute(stopIds));
         } else {
-            it->second.addTram(tramName);
+            route = internRoute(sharedRoutes, hash, std::vector<std::string>(stopNames));
         }
     }
+    {
+        MemoryScope names(MemoryCategory::NAMES);
+        std::string key = tramName;
+        Tram tram = compactRoutes ? Tram(tramName, encodedRoute) : Tram(tramName, route);
+        MemoryScope nodes(MemoryCategory::MAP_NODES);
+        trams.emplace(std::move(key), std::move(tram));
+    }
+    networkIndexDirty = true;
+    routingGraphDirty = true;
+    transferPatterns.clear();
+
+    MemoryScope scope(MemoryCategory::INDEXES);
+    positions.addTram(tramName);
+    tramFilter.insert(tramName);
+    for (int id = firstNewId; id < static_cast<int>(stopById.size()); ++id) {
+        stopFilter.insert(stopById[id]->getName());
+    }
+    if (stopFilter.full() || tramFilter.full()) {
+        rebuildFilters();
+    }
+    return stopIds;
 }
 
-std::vector<std::string> TramSystem::getTramsInStop(const std::string& stopName) const {
+std::vector<int> TramSystem::detachTram(std::map<std::string, Tram>::iterator it) {
+    std::string tramName = it->first;
+    std::vector<int> stopIds = getRouteIds(it->second);
+    for (int id : stopIds) {
+        stops.find(stopById[id]->getName())->second.removeTram(tramName);
+    }
+    trams.erase(it);
+    if (compactRoutes) {
+        releaseRoutes(sharedEncodedRoutes, hashRoute(stopIds));
+    } else {
+        releaseRoutes(sharedRoutes, hashRoute(stopIds));
+    }
+
+    // Из union-find нельзя убрать связь, поэтому компоненты пересчитываются при следующем запросе
+    // связности, один раз на серию удалений. Остановки не удаляются, их фильтр не меняется
+    connectivityDirty = true;
+    networkIndexDirty = true;
+    routingGraphDirty = true;
+    transferPatterns.clear();
+    positions.removeTram(tramName);
+
+    // Имя удаленного трамвая остается в фильтре и дает лишний поиск в словаре; фильтр пересобирается,
+    // когда таких имен становится больше половины живых, поэтому удаление в среднем стоит O(1)
+    if (++removedTrams * 2 > trams.size()) {
+        rebuildTramFilter();
+    }
+    return stopIds;
+}
+
+void TramSystem::publishRouteChange(const std::string& tramName, const std::vector<int>& oldStops,
+                                    const std::vector<int>& newStops, int firstNewId) {
+    if (changeFeed.empty()) {
+        return;
+    }
+    // Маршруты короткие, поэтому разница считается по отсортированным копиям без хэш-таблиц
+    std::vector<int> before = oldStops, after = newStops;
+    for (std::vector<int>* ids : {&before, &after}) {
+        std::sort(ids->begin(), ids->end());
+        ids->erase(std::unique(ids->begin(), ids->end()), ids->end());
+    }
+    for (int id : before) {
+        if (!std::binary_search(after.begin(), after.end(), id)) {
+            changeFeed.publish({tramName, stopById[id]->getName(), false, true});
+        }
+    }
+    // Новые остановки публикуются в порядке маршрута, как их видит пассажир
+    std::vector<int> published;
+    for (int id : newStops) {
+        if (std::binary_search(before.begin(), before.end(), id)) continue;
+        if (std::find(published.begin(), published.end(), id) != published.end()) continue;
+        published.push_back(id);
+        changeFeed.publish({tramName, stopById[id]->getName(), id >= firstNewId, false});
+    }
+}
+
+const DisjointSet& TramSystem::getConnectivity() const {
+    if (connectivityDirty) {
+        MemoryScope scope(MemoryCategory::INDEXES);
+        connectivity = DisjointSet();
+        for (size_t id = 0; id < stopById.size(); ++id) {
+            connectivity.add();
+        }
+        for (const auto& [name, tram] : trams) {
+            std::vector<int> stopIds = getRouteIds(tram);
+            for (size_t i = 1; i < stopIds.size(); ++i) {
+                connectivity.unite(stopIds[0], stopIds[i]);
+            }
+        }
+        connectivityDirty = false;
+    }
+    return connectivity;
+}
+
+std::map<std::string, Stop>::const_iterator TramSystem::lookupStop(const std::string& stopName) const {
+    TraceSpan span("lookup stop", stopName);
+    ++stopLookups.lookups;
+    if (!stopFilter.mayContain(stopName)) {
+        ++stopLookups.rejected;
+        return stops.end();
+    }
     auto it = stops.find(stopName);
+    if (it == stops.end()) {
+        ++stopLookups.falsePositives;
+    }
+    return it;
+}
+
+std::map<std::string, Tram>::const_iterator TramSystem::lookupTram(const std::string& tramName) const {
+    TraceSpan span("lookup tram", tramName);
+    ++tramLookups.lookups;
+    if (!tramFilter.mayContain(tramName)) {
+        ++tramLookups.rejected;
+        return trams.end();
+    }
+    auto it = trams.find(tramName);
+    if (it == trams.end()) {
+        ++tramLookups.falsePositives;
+    }
+    return it;
+}
+
+void TramSystem::rebuildFilters() {
+    MemoryScope scope(MemoryCategory::INDEXES);
+    stopFilter.reset(stops.size() * 2);
+    for (const auto& [name, stop] : stops) {
+        stopFilter.insert(name);
+    }
+    rebuildTramFilter();
+}
+
+void TramSystem::rebuildTramFilter() {
+    MemoryScope scope(MemoryCategory::INDEXES);
+    tramFilter.reset(trams.size() * 2);
+    for (const auto& [name, tram] : trams) {
+        tramFilter.insert(name);
+    }
+    removedTrams = 0;
+}
+
+const BloomFilter& TramSystem::getStopFilter() const {
+    return stopFilter;
+}
+
+const BloomFilter& TramSystem::getTramFilter() const {
+    return tramFilter;
+}
+
+const LookupStats& TramSystem::getStopLookupStats() const {
+    return stopLookups;
+}
+
+const LookupStats& TramSystem::getTramLookupStats() const {
+    return tramLookups;
+}
+
+ChangeFeed& TramSystem::getChangeFeed() {
+    return changeFeed;
+}
+
+std::vector<int> TramSystem::getRouteIds(const Tram& tram) const {
+    if (tram.isCompact()) {
+        return decodeRoute(tram.getEncodedStops());
+    }
+
+    std::vector<int> ids;
+    ids.reserve(tram.getStops().size());
+    for (const auto& stopName : tram.getStops()) {
+        ids.push_back(stops.at(stopName).getId());
+    }
+    return ids;
+}
+
+int TramSystem::getStopId(const std::string& stopName) const {
+    auto it = lookupStop(stopName);
+    if (it == stops.end()) {
+        throw std::invalid_argument("Stop '" + stopName + "' does not exist");
+    }
+    return it->second.getId();
+}
+
+const Stop* TramSystem::findStop(const std::string& stopName) const {
+    auto it = lookupStop(stopName);
+    return it == stops.end() ? nullptr : &it->second;
+}
+
+std::vector<const Stop*> TramSystem::getRoute(const std::string& tramName) const {
+    std::vector<const Stop*> route;
+    auto tramIt = lookupTram(tramName);
+    if (tramIt == trams.end()) {
+        return route;
+    }
+
+    // В компактном режиме маршрут декодируется на лету прямо в указатели на остановки
+    if (tramIt->second.isCompact()) {
+        for (int id : decodeRoute(tramIt->second.getEncodedStops())) {
+            route.push_back(stopById[id]);
+        }
+    } else {
+        for (const auto& stopName : tramIt->second.getStops()) {
+            route.push_back(&stops.at(stopName));
+        }
+    }
+    return route;
+}
+
+const std::map<std::string, Tram>& TramSystem::getTrams() const {
+    return trams;
+}
+
+size_t TramSystem::getStopCount() const {
+    return stops.size();
+}
+
+size_t TramSystem::estimateMemory() const {
+    size_t bytes = sizeof(TramSystem);
+    std::unordered_set<const void*> countedRoutes; // Общий маршрут учитывается один раз
+    for (const auto& [name, tram] : trams) {
+        bytes += MAP_NODE_OVERHEAD + sizeof(std::pair<const std::string, Tram>);
+        bytes += stringHeapBytes(name) + stringHeapBytes(tram.getName());
+        if (!countedRoutes.insert(tram.getRouteStorage()).second) {
+            continue;
+        }
+        bytes += vectorHeapBytes(tram.getStops()) + vectorHeapBytes(tram.getEncodedStops());
+        for (const auto& stopName : tram.getStops()) {
+            bytes += stringHeapBytes(stopName);
+        }
+    }
+    for (const auto& [name, stop] : stops) {
+        bytes += MAP_NODE_OVERHEAD + sizeof(std::pair<const std::string, Stop>);
+        bytes += stringHeapBytes(name) + stringHeapBytes(stop.getName());
+        bytes += vectorHeapBytes(stop.getTrams());
+        for (const auto& tramName : stop.getTrams()) {
+            bytes += stringHeapBytes(tramName);
+        }
+    }
+    bytes += vectorHeapBytes(stopById) + stopById.size() * 2 * sizeof(int); // ID и союз-поиск
+    bytes += vectorHeapBytes(networkIndex.tramStopStart) + vectorHeapBytes(networkIndex.tramStops)
+           + vectorHeapBytes(networkIndex.stopTramStart) + vectorHeapBytes(networkIndex.stopTrams);
+    return bytes;
+}
+
+std::vector<std::string> TramSystem::getTramsInStop(const std::string& stopName) const {
+    auto it = lookupStop(stopName);
     if (it != stops.end()) {
         return it->second.getTrams();
     }
@@ -43,22 +422,14 @@ std::vector<std::string> TramSystem::getTramsInStop(const std::string& stopName)
 std::vector<std::pair<std::string, std::vector<std::string>>> TramSystem::getStopsInTram(const std::string& tramName) const {
     std::vector<std::pair<std::string, std::vector<std::string>>> result;
     
-    auto tramIt = trams.find(tramName);
-    if (tramIt == trams.end()) {
-        return result;
-    }
-    
-    for (const auto& stopName : tramIt->second.getStops()) {
-        auto stopIt = stops.find(stopName);
-        if (stopIt != stops.end()) {
-            std::vector<std::string> otherTrams;
-            for (const auto& tram : stopIt->second.getTrams()) {
-                if (tram != tramName) {
-                    otherTrams.push_back(tram);
-                }
+    for (const Stop* stop : getRoute(tramName)) {
+        std::vector<std::string> otherTrams;
+        for (const auto& tram : stop->getTrams()) {
+            if (tram != tramName) {
+                otherTrams.push_back(tram);
             }
-            result.emplace_back(stopName, otherTrams);
         }
+        result.emplace_back(stop->getName(), otherTrams);
     }
     
     return result;
@@ -68,8 +439,396 @@ std::map<std::string, std::vector<std::string>> TramSystem::getAllTrams() const
     std::map<std::string, std::vector<std::string>> result;
     
     for (const auto& tramPair : trams) {
-        result[tramPair.first] = tramPair.second.getStops();
+        if (tramPair.second.isCompact()) {
+            auto& names = result[tramPair.first];
+            for (int id : decodeRoute(tramPair.second.getEncodedStops())) {
+                names.push_back(stopById[id]->getName());
+            }
+        } else {
+            result[tramPair.first] = tramPair.second.getStops();
+        }
     }
     
     return result;
-}
\ No newline at end of file
+}
+
+bool TramSystem::areConnected(const std::string& stopA, const std::string& stopB) const {
+    return getConnectivity().connected(getStopId(stopA), getStopId(stopB));
+}
+
+int TramSystem::getComponentsCount() const {
+    return getConnectivity().count();
+}
+
+void TramSystem::setStopCoordinates(const std::string& stopName, double lat, double lon) {
+    auto it = stops.find(stopName);
+    if (it == stops.end()) {
+        throw std::invalid_argument("Stop '" + stopName + "' does not exist");
+    }
+    if (lat < -90.0 || lat > 90.0 || lon < -180.0 || lon > 180.0) {
+        throw std::invalid_argument("Coordinates out of range");
+    }
+    it->second.setCoordinates(lat, lon);
+    spatialIndexDirty = true;
+    footpathsDirty = true;
+    routingGraphDirty = true;
+    transferPatterns.clear();
+}
+
+int TramSystem::loadCoordinates(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) {
+        throw std::invalid_argument("Cannot open file '" + path + "'");
+    }
+
+    // Неизвестные остановки и некорректные строки пропускаются, сетка пересобирается один раз при следующем запросе
+    int loaded = 0;
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream iss(line);
+        std::string stopName;
+        double lat, lon;
+        if (!(iss >> stopName >> lat >> lon)) {
+            continue;
+        }
+        auto it = stops.find(stopName);
+        if (it == stops.end() || lat < -90.0 || lat > 90.0 || lon < -180.0 || lon > 180.0) {
+            continue;
+        }
+        it->second.setCoordinates(lat, lon);
+        ++loaded;
+    }
+
+    spatialIndexDirty = true;
+    footpathsDirty = true;
+    routingGraphDirty = true;
+    transferPatterns.clear();
+    return loaded;
+}
+
+const SpatialIndex& TramSystem::getSpatialIndex() const {
+    if (spatialIndexDirty) {
+        MemoryScope scope(MemoryCategory::INDEXES);
+        std::vector<int> ids;
+        std::vector<double> lats, lons;
+        for (const auto& [name, stop] : stops) {
+            if (stop.hasCoordinates()) {
+                ids.push_back(stop.getId());
+                lats.push_back(stop.getLat());
+                lons.push_back(stop.getLon());
+            }
+        }
+        spatialIndex.build(ids, lats, lons);
+        spatialIndexDirty = false;
+    }
+    return spatialIndex;
+}
+
+std::vector<std::pair<std::string, double>> TramSystem::toNamedStops(const std::vector<std::pair<int, double>>& found) const {
+    std::vector<std::pair<std::string, double>> result;
+    result.reserve(found.size());
+    for (const auto& [id, distance] : found) {
+        result.emplace_back(stopById[id]->getName(), distance);
+    }
+    return result;
+}
+
+std::vector<std::pair<std::string, double>> TramSystem::getNearestStops(double lat, double lon, int k) const {
+    return toNamedStops(getSpatialIndex().nearest(lat, lon, k));
+}
+
+std::vector<std::pair<std::string, double>> TramSystem::getStopsInRadius(double lat, double lon, double radius) const {
+    return toNamedStops(getSpatialIndex().withinRadius(lat, lon, radius));
+}
+
+const FootpathTable& TramSystem::getFootpaths() const {
+    if (footpathsDirty) {
+        MemoryScope scope(MemoryCategory::INDEXES);
+        size_t stopCount = stopById.size();
+        std::vector<double> lats(stopCount, NAN), lons(stopCount, NAN);
+        std::vector<char> hasCoords(stopCount, 0);
+        for (const auto& [name, stop] : stops) {
+            if (stop.hasCoordinates()) {
+                lats[stop.getId()] = stop.getLat();
+                lons[stop.getId()] = stop.getLon();
+                hasCoords[stop.getId()] = 1;
+            }
+        }
+        footpaths.build(getSpatialIndex(), lats, lons, hasCoords);
+        footpathsDirty = false;
+    }
+    return footpaths;
+}
+
+std::vector<std::pair<std::string, int>> TramSystem::getFootpathsFrom(const std::string& stopName) const {
+    std::vector<std::pair<std::string, int>> result;
+    auto [begin, end] = getFootpaths().from(getStopId(stopName));
+    for (const Footpath* path = begin; path != end; ++path) {
+        result.emplace_back(stopById[path->stop]->getName(), path->seconds);
+    }
+    return result;
+}
+
+const NetworkIndex& TramSystem::getNetworkIndex() const {
+    if (networkIndexDirty) {
+        MemoryScope scope(MemoryCategory::INDEXES);
+        NetworkIndex index;
+        index.tramStopStart.push_back(0);
+        std::unordered_map<const void*, std::pair<int, int>> decoded; // Общий маршрут декодируется один раз, дальше копируется
+        for (const auto& [name, tram] : trams) {
+            index.tramNames.push_back(name);
+            auto it = decoded.find(tram.getRouteStorage());
+            if (it == decoded.end()) {
+                int begin = static_cast<int>(index.tramStops.size());
+                std::vector<int> ids = getRouteIds(tram);
+                index.tramStops.insert(index.tramStops.end(), ids.begin(), ids.end());
+                decoded.emplace(tram.getRouteStorage(), std::make_pair(begin, static_cast<int>(index.tramStops.size())));
+            } else {
+                for (int i = it->second.first; i < it->second.second; ++i) {
+                    index.tramStops.push_back(index.tramStops[i]);
+                }
+            }
+            index.tramStopStart.push_back(static_cast<int>(index.tramStops.size()));
+        }
+        index.buildStopTrams(static_cast<int>(stopById.size()));
+        networkIndex = std::move(index);
+        networkIndexDirty = false;
+    }
+    return networkIndex;
+}
+
+std::vector<std::string> TramSystem::getReachableStops(const std::string& stopName, int maxTrams) const {
+    int origin = getStopId(stopName);
+    std::vector<std::string> result;
+    for (int id : reachableStops(getNetworkIndex(), getFootpaths(), origin, maxTrams)) {
+        result.push_back(stopById[id]->getName());
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+std::vector<int> TramSystem::getReachableCounts(const std::vector<std::string>& stopNames, int maxTrams) const {
+    std::vector<int> origins;
+    origins.reserve(stopNames.size());
+    for (const auto& stopName : stopNames) {
+        origins.push_back(getStopId(stopName));
+    }
+    return reachableCounts(getNetworkIndex(), getFootpaths(), origins, maxTrams);
+}
+
+std::vector<std::tuple<std::string, std::string, int>> TramSystem::getTramOverlaps(int minShared) const {
+    const NetworkIndex& index = getNetworkIndex();
+    std::vector<std::tuple<std::string, std::string, int>> result;
+    for (const auto& overlap : tramOverlaps(index, minShared)) {
+        result.emplace_back(index.tramNames[overlap.tramA], index.tramNames[overlap.tramB], overlap.shared);
+    }
+    return result;
+}
+
+std::vector<std::pair<std::string, double>> TramSystem::getHubs(int topN, int samples) const {
+    std::vector<double> centrality = betweennessCentrality(getNetworkIndex(), samples);
+
+    std::vector<int> order(centrality.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        order[i] = static_cast<int>(i);
+    }
+    size_t count = std::min(order.size(), static_cast<size_t>(std::max(topN, 0)));
+    std::partial_sort(order.begin(), order.begin() + count, order.end(), [&](int a, int b) {
+        if (centrality[a] != centrality[b]) return centrality[a] > centrality[b];
+        return stopById[a]->getName() < stopById[b]->getName();
+    });
+
+    std::vector<std::pair<std::string, double>> result;
+    for (size_t i = 0; i < count; ++i) {
+        result.emplace_back(stopById[order[i]]->getName(), centrality[order[i]]);
+    }
+    return result;
+}
+
+int TramSystem::findRouteIndex(const std::string& tramName, int stopId) const {
+    const NetworkIndex& index = getNetworkIndex();
+    auto it = std::lower_bound(index.tramNames.begin(), index.tramNames.end(), tramName);
+    if (it == index.tramNames.end() || *it != tramName) {
+        return -1;
+    }
+    return findRouteIndex(static_cast<int>(it - index.tramNames.begin()), stopId);
+}
+
+int TramSystem::findRouteIndex(int tram, int stopId) const {
+    const NetworkIndex& index = getNetworkIndex();
+    for (int i = index.tramStopStart[tram]; i < index.tramStopStart[tram + 1]; ++i) {
+        if (index.tramStops[i] == stopId) {
+            return i - index.tramStopStart[tram];
+        }
+    }
+    return -1;
+}
+
+bool TramSystem::updatePosition(const std::string& tramName, const std::string& stopName, uint32_t timestamp) {
+    auto stopIt = lookupStop(stopName);
+    if (stopIt == stops.end()) {
+        return false;
+    }
+    int routeIndex = findRouteIndex(tramName, stopIt->second.getId());
+    if (routeIndex < 0) {
+        return false;
+    }
+    return positions.update(tramName, static_cast<uint32_t>(routeIndex), timestamp);
+}
+
+int TramSystem::ingestPositions(const std::string& path, int& rejected) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        throw std::invalid_argument("Cannot open file '" + path + "'");
+    }
+
+    // Файл читается целиком, строки разбираются без istringstream. Имена разрешаются в ID один раз
+    // на файл: строка с уже встреченными именами стоит двух поисков по string_view в хеш-таблицах
+    // без выделения памяти и обновления слота напрямую
+    std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    const NetworkIndex& index = getNetworkIndex();
+    struct TramIds {
+        int tram = -1; // ID в снимке сети, -1 для неизвестного трамвая
+        VehiclePositions::Slot* slot = nullptr;
+    };
+    std::unordered_map<std::string_view, TramIds> tramIds;
+    std::unordered_map<std::string_view, int> stopIds; // -1 для неизвестной остановки
+    int accepted = 0;
+    rejected = 0;
+
+    size_t pos = 0;
+    while (pos < data.size()) {
+        size_t lineEnd = data.find('\n', pos);
+        if (lineEnd == std::string::npos) lineEnd = data.size();
+
+        std::string_view fields[3];
+        int count = 0;
+        size_t i = pos;
+        while (i < lineEnd && count < 3) {
+            while (i < lineEnd && std::isspace(static_cast<unsigned char>(data[i]))) ++i;
+            size_t start = i;
+            while (i < lineEnd && !std::isspace(static_cast<unsigned char>(data[i]))) ++i;
+            if (i > start) fields[count++] = std::string_view(data.data() + start, i - start);
+        }
+        pos = lineEnd + 1;
+        if (count == 0) continue;
+
+        uint32_t timestamp = 0;
+        bool valid = count == 3 && parseTimestamp(fields[2], timestamp);
+        if (valid) {
+            auto [tramIt, newTram] = tramIds.try_emplace(fields[0]);
+            if (newTram) {
+                std::string tramName(fields[0]);
+                auto it = std::lower_bound(index.tramNames.begin(), index.tramNames.end(), tramName);
+                if (it != index.tramNames.end() && *it == tramName) {
+                    tramIt->second.tram = static_cast<int>(it - index.tramNames.begin());
+                    tramIt->second.slot = positions.find(tramName);
+                }
+            }
+            auto [stopIt, newStop] = stopIds.try_emplace(fields[1], -1);
+            if (newStop) {
+                auto it = lookupStop(std::string(fields[1]));
+                if (it != stops.end()) stopIt->second = it->second.getId();
+            }
+
+            const TramIds& ids = tramIt->second;
+            int routeIndex = ids.slot && stopIt->second >= 0 ? findRouteIndex(ids.tram, stopIt->second) : -1;
+            valid = routeIndex >= 0 && VehiclePositions::update(*ids.slot, static_cast<uint32_t>(routeIndex), timestamp);
+        }
+        valid ? ++accepted : ++rejected;
+    }
+    return accepted;
+}
+
+std::vector<PredictedArrival> TramSystem::getNextTrams(const std::string& stopName) const {
+    int stopId = getStopId(stopName);
+    const NetworkIndex& index = getNetworkIndex();
+
+    std::vector<PredictedArrival> result;
+    for (int t = index.stopTramStart[stopId]; t < index.stopTramStart[stopId + 1]; ++t) {
+        int tram = index.stopTrams[t];
+        VehiclePosition position = positions.get(index.tramNames[tram]);
+        if (!position.known) continue;
+
+        // Ближайшее вхождение остановки в маршрут после последней пройденной
+        int begin = index.tramStopStart[tram];
+        int end = index.tramStopStart[tram + 1];
+        for (int i = begin + static_cast<int>(position.routeIndex) + 1; i < end; ++i) {
+            if (index.tramStops[i] == stopId) {
+                PredictedArrival arrival;
+                arrival.tram = index.tramNames[tram];
+                arrival.stopsAway = i - begin - static_cast<int>(position.routeIndex);
+                arrival.eta = position.timestamp + static_cast<uint32_t>(arrival.stopsAway * RIDE_SECONDS_PER_HOP);
+                result.push_back(arrival);
+                break;
+            }
+        }
+    }
+
+    std::sort(result.begin(), result.end(), [](const PredictedArrival& a, const PredictedArrival& b) {
+        return a.eta < b.eta;
+    });
+    return result;
+}
+
+const StopGraph& TramSystem::getRoutingGraph() const {
+    if (routingGraphDirty) {
+        MemoryScope scope(MemoryCategory::INDEXES);
+        routingGraph.build(getNetworkIndex(), getFootpaths(), RIDE_SECONDS_PER_HOP, TRANSFER_SECONDS);
+        routingGraphDirty = false;
+    }
+    return routingGraph;
+}
+
+Journey TramSystem::toJourney(const StopPath& path) const {
+    const NetworkIndex& index = getNetworkIndex();
+    Journey journey;
+    journey.seconds = path.seconds;
+    for (int id : path.stops) {
+        journey.stops.push_back(stopById[id]->getName());
+    }
+    for (const PathLeg& leg : path.legs) {
+        journey.legs.push_back({leg.tram < 0 ? std::string() : index.tramNames[leg.tram],
+                                journey.stops[leg.from], journey.stops[leg.to]});
+    }
+    return journey;
+}
+
+std::vector<Journey> TramSystem::getRoutes(const std::string& fromStop, const std::string& toStop, int k) const {
+    int from = getStopId(fromStop);
+    int to = getStopId(toStop);
+    if (k <= 0) {
+        throw std::invalid_argument("Number of routes must be positive");
+    }
+
+    std::vector<Journey> result;
+    if (k == 1 && !transferPatterns.empty() && from != to) {
+        // Шаблон пересадок проверяется по текущей сети; если он не подошел, работает обычный поиск
+        StopPath path;
+        if (expandPattern(getNetworkIndex(), getFootpaths(), RIDE_SECONDS_PER_HOP, TRANSFER_SECONDS,
+                          transferPatterns.find(from, to), path)) {
+            result.push_back(toJourney(path));
+            return result;
+        }
+    }
+
+    for (const StopPath& path : kShortestPaths(getRoutingGraph(), from, to, k)) {
+        result.push_back(toJourney(path));
+    }
+    return result;
+}
+
+void TramSystem::precomputeTransferPatterns(const std::string& path) {
+    MemoryScope scope(MemoryCategory::INDEXES);
+    transferPatterns.build(getRoutingGraph());
+    transferPatterns.save(path);
+}
+
+void TramSystem::loadTransferPatterns(const std::string& path) {
+    MemoryScope scope(MemoryCategory::INDEXES);
+    transferPatterns.load(path, getRoutingGraph());
+}
+
+const TransferPatterns& TramSystem::getTransferPatterns() const {
+    return transferPatterns;
+}
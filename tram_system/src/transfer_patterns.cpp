@@ -0,0 +1,373 @@
+#include "transfer_patterns.h"
+#include "parallel.h"
+#include "route_codec.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <climits>
+#include <cstdlib>
+#include <fstream>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace {
+
+const char MAGIC[4] = {'T', 'P', 'A', 'T'};
+const uint32_t VERSION = 2;
+
+void writeInt(std::ofstream& file, uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; ++i) {
+        file.put(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+}
+
+uint64_t readInt(std::ifstream& file, int bytes) {
+    uint64_t value = 0;
+    for (int i = 0; i < bytes; ++i) {
+        int c = file.get();
+        if (c == EOF) {
+            throw std::invalid_argument("Transfer patterns file is truncated");
+        }
+        value |= static_cast<uint64_t>(c) << (8 * i);
+    }
+    return value;
+}
+
+// Массив хранится как длина блока и delta/varint-поток, как маршруты в компактном режиме
+void writeBlock(std::ofstream& file, const std::vector<int>& values) {
+    std::vector<uint8_t> data = encodeRoute(values);
+    writeInt(file, data.size(), 4);
+    file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+}
+
+std::vector<int> readBlock(std::ifstream& file) {
+    std::vector<uint8_t> data(readInt(file, 4));
+    if (!file.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size()))) {
+        throw std::invalid_argument("Transfer patterns file is truncated");
+    }
+    return decodeRoute(data);
+}
+
+} // namespace
+
+void TransferPatterns::build(const StopGraph& graph) {
+    int count = graph.stopCount();
+    int nodes = graph.nodeCount();
+    std::vector<OriginPatterns> built(count);
+    std::atomic<size_t> total{0};
+    std::atomic<bool> overflow{false};
+
+    // Каждый поток считает свой диапазон остановок отправления со своими буферами
+    parallelFor(count, [&](size_t begin, size_t end, unsigned) {
+        std::vector<int> prev, order;
+        std::vector<int> anchor(nodes); // Ближайшая вершина-остановка выше по дереву: там кончился предыдущий участок
+        std::vector<int> rank(nodes); // Номер вершины в order: кто раньше, тот ближе
+        std::vector<size_t> rankOrigin(nodes, SIZE_MAX); // Для какой остановки отправления заполнен rank
+        std::vector<int> patternNode(nodes); // Узел DAG для вершины-остановки дерева, если уже создан
+        std::vector<size_t> patternOrigin(nodes, SIZE_MAX);
+        std::unordered_map<uint64_t, int> nodeByKey; // (родитель, остановка) -> узел, чтобы не повторять узлы
+        std::vector<int> chain;
+        for (size_t origin = begin; origin < end && !overflow.load(std::memory_order_relaxed); ++origin) {
+            OriginPatterns& patterns = built[origin];
+            patterns.nodeStops.assign(1, static_cast<int>(origin));
+            patterns.nodeParents.assign(1, -1);
+            nodeByKey.clear();
+            int root = graph.freshNode(static_cast<int>(origin));
+            patternNode[root] = 0;
+            patternOrigin[root] = origin;
+
+            shortestPathTree(graph, root, prev, order);
+            for (size_t i = 0; i < order.size(); ++i) {
+                int v = order[i];
+                rank[v] = static_cast<int>(i);
+                rankOrigin[v] = origin;
+                if (v != root) anchor[v] = graph.isStopNode(prev[v]) ? prev[v] : anchor[prev[v]];
+            }
+
+            // Узел DAG для вершины-остановки: сначала цепочка еще не созданных предков, потом узлы сверху вниз
+            auto nodeFor = [&](int vertex) {
+                chain.clear();
+                for (int w = vertex; patternOrigin[w] != origin; w = anchor[w]) {
+                    chain.push_back(w);
+                }
+                for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+                    int parent = patternNode[anchor[*it]];
+                    int stop = graph.stopOf(*it);
+                    uint64_t key = (static_cast<uint64_t>(parent) << 32) | static_cast<uint32_t>(stop);
+                    auto [found, inserted] = nodeByKey.emplace(key, static_cast<int>(patterns.nodeStops.size()));
+                    if (inserted) {
+                        patterns.nodeStops.push_back(stop);
+                        patterns.nodeParents.push_back(parent);
+                    }
+                    patternNode[*it] = found->second;
+                    patternOrigin[*it] = origin;
+                }
+                return patternNode[vertex];
+            };
+
+            // Назначение - та из двух вершин остановки, до которой дорога короче
+            for (int dest = 0; dest < count; ++dest) {
+                if (dest == static_cast<int>(origin)) continue;
+                int best = -1;
+                for (int vertex : {dest, graph.freshNode(dest)}) {
+                    if (rankOrigin[vertex] == origin && (best < 0 || rank[vertex] < rank[best])) best = vertex;
+                }
+                if (best < 0) continue;
+                int last = nodeFor(anchor[best]);
+                if (last != 0) {
+                    patterns.destStops.push_back(dest);
+                    patterns.destNodes.push_back(last);
+                }
+            }
+
+            size_t entries = patterns.nodeStops.size() + patterns.destStops.size();
+            if (total.fetch_add(entries) + entries > MAX_ENTRIES) {
+                overflow = true;
+            }
+        }
+    });
+
+    if (overflow) {
+        throw std::invalid_argument("Transfer patterns exceed " + std::to_string(MAX_ENTRIES) + " entries");
+    }
+    origins = std::move(built);
+    fingerprint = graphFingerprint(graph);
+}
+
+void TransferPatterns::save(const std::string& path) const {
+    std::ofstream file(path, std::ios::binary);
+    if (!file) {
+        throw std::invalid_argument("Cannot open file '" + path + "'");
+    }
+    file.write(MAGIC, sizeof(MAGIC));
+    writeInt(file, VERSION, 4);
+    writeInt(file, origins.size(), 4);
+    writeInt(file, fingerprint, 8);
+    for (const OriginPatterns& patterns : origins) {
+        writeBlock(file, patterns.nodeStops);
+        writeBlock(file, patterns.nodeParents);
+        writeBlock(file, patterns.destStops);
+        writeBlock(file, patterns.destNodes);
+    }
+    if (!file) {
+        throw std::invalid_argument("Cannot write file '" + path + "'");
+    }
+}
+
+void TransferPatterns::load(const std::string& path, const StopGraph& graph) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        throw std::invalid_argument("Cannot open file '" + path + "'");
+    }
+    char magic[sizeof(MAGIC)];
+    if (!file.read(magic, sizeof(magic)) || !std::equal(magic, magic + sizeof(magic), MAGIC) || readInt(file, 4) != VERSION) {
+        throw std::invalid_argument("'" + path + "' is not a transfer patterns file");
+    }
+    size_t count = readInt(file, 4);
+    uint64_t storedFingerprint = readInt(file, 8);
+    if (count != static_cast<size_t>(graph.stopCount()) || storedFingerprint != graphFingerprint(graph)) {
+        throw std::invalid_argument("Transfer patterns were computed for a different network");
+    }
+
+    std::vector<OriginPatterns> loaded(count);
+    size_t total = 0;
+    for (size_t origin = 0; origin < count; ++origin) {
+        OriginPatterns& patterns = loaded[origin];
+        patterns.nodeStops = readBlock(file);
+        patterns.nodeParents = readBlock(file);
+        patterns.destStops = readBlock(file);
+        patterns.destNodes = readBlock(file);
+        total += patterns.nodeStops.size() + patterns.destStops.size();
+        if (total > MAX_ENTRIES) {
+            throw std::invalid_argument("Transfer patterns exceed " + std::to_string(MAX_ENTRIES) + " entries");
+        }
+
+        // Проверяем ссылки, чтобы поиск по поврежденному файлу не вышел за границы
+        int nodes = static_cast<int>(patterns.nodeStops.size());
+        bool valid = nodes > 0 && patterns.nodeStops[0] == static_cast<int>(origin) &&
+                     patterns.nodeParents.size() == patterns.nodeStops.size() &&
+                     patterns.destNodes.size() == patterns.destStops.size();
+        for (int node = 0; valid && node < nodes; ++node) {
+            int stop = patterns.nodeStops[node];
+            valid = stop >= 0 && static_cast<size_t>(stop) < count &&
+                    patterns.nodeParents[node] < node && (node == 0) == (patterns.nodeParents[node] < 0);
+        }
+        for (size_t i = 0; valid && i < patterns.destStops.size(); ++i) {
+            int dest = patterns.destStops[i];
+            valid = dest >= 0 && static_cast<size_t>(dest) < count && (i == 0 || patterns.destStops[i - 1] < dest) &&
+                    patterns.destNodes[i] > 0 && patterns.destNodes[i] < nodes;
+        }
+        if (!valid) {
+            throw std::invalid_argument("Transfer patterns file is corrupted");
+        }
+    }
+    origins = std::move(loaded);
+    fingerprint = storedFingerprint;
+}
+
+void TransferPatterns::clear() {
+    origins.clear();
+    fingerprint = 0;
+}
+
+bool TransferPatterns::empty() const {
+    return origins.empty();
+}
+
+size_t TransferPatterns::patternCount() const {
+    size_t count = 0;
+    for (const OriginPatterns& patterns : origins) {
+        count += patterns.destStops.size();
+    }
+    return count;
+}
+
+size_t TransferPatterns::nodeCount() const {
+    size_t count = 0;
+    for (const OriginPatterns& patterns : origins) {
+        count += patterns.nodeStops.size();
+    }
+    return count;
+}
+
+std::vector<int> TransferPatterns::find(int from, int to) const {
+    std::vector<int> pattern;
+    if (from < 0 || to < 0 || static_cast<size_t>(from) >= origins.size() || static_cast<size_t>(to) >= origins.size()) {
+        return pattern;
+    }
+    const OriginPatterns& patterns = origins[from];
+    auto it = std::lower_bound(patterns.destStops.begin(), patterns.destStops.end(), to);
+    int last = 0; // Назначения без записи достижимы без пересадок
+    if (it != patterns.destStops.end() && *it == to) {
+        last = patterns.destNodes[it - patterns.destStops.begin()];
+    }
+    pattern.push_back(to);
+    for (int node = last; node >= 0; node = patterns.nodeParents[node]) {
+        pattern.push_back(patterns.nodeStops[node]);
+    }
+    std::reverse(pattern.begin(), pattern.end());
+    return pattern;
+}
+
+uint64_t TransferPatterns::graphFingerprint(const StopGraph& graph) {
+    // FNV-1a по структуре графа: любая новая линия или пересадка меняет отпечаток
+    uint64_t hash = 14695981039346656037ULL;
+    auto mix = [&hash](int value) {
+        hash = (hash ^ static_cast<uint32_t>(value)) * 1099511628211ULL;
+    };
+    for (int value : graph.start) {
+        mix(value);
+    }
+    for (const GraphEdge& edge : graph.edges) {
+        mix(edge.to);
+        mix(edge.seconds);
+        mix(static_cast<int>(edge.kind));
+    }
+    return hash;
+}
+
+bool expandPattern(const NetworkIndex& network, const FootpathTable& footpaths, int rideSeconds, int transferSeconds,
+                   const std::vector<int>& pattern, StopPath& path) {
+    path = StopPath();
+    if (pattern.empty()) {
+        return false;
+    }
+
+    // Для каждой пары соседних остановок шаблона - лучший трамвай и пешая пересадка
+    struct Hop {
+        int tram = -1;
+        int from = 0;
+        int to = 0;
+        int hops = INT_MAX;
+        int walkSeconds = INT_MAX;
+    };
+    std::vector<Hop> hops(pattern.size() - 1);
+    for (size_t i = 1; i < pattern.size(); ++i) {
+        int a = pattern[i - 1];
+        int b = pattern[i];
+        Hop& hop = hops[i - 1];
+
+        // Трамвай, на котором от a до b меньше всего перегонов (в любую сторону по маршруту)
+        auto consider = [&](int tram, int from, int to) {
+            if (std::abs(to - from) < hop.hops) {
+                hop.tram = tram;
+                hop.from = from;
+                hop.to = to;
+                hop.hops = std::abs(to - from);
+            }
+        };
+        for (int t = network.stopTramStart[a]; t < network.stopTramStart[a + 1]; ++t) {
+            int tram = network.stopTrams[t];
+            int lastA = -1, lastB = -1;
+            for (int j = network.tramStopStart[tram]; j < network.tramStopStart[tram + 1]; ++j) {
+                if (network.tramStops[j] == a) {
+                    lastA = j;
+                    if (lastB >= 0) consider(tram, j, lastB);
+                } else if (network.tramStops[j] == b) {
+                    lastB = j;
+                    if (lastA >= 0) consider(tram, lastA, j);
+                }
+            }
+        }
+
+        auto [begin, end] = footpaths.from(a);
+        for (const Footpath* footpath = begin; footpath != end; ++footpath) {
+            if (footpath->stop == b) hop.walkSeconds = footpath->seconds;
+        }
+        if (hop.tram < 0 && hop.walkSeconds == INT_MAX) {
+            return false; // Сеть изменилась: прямого участка между остановками шаблона больше нет
+        }
+    }
+
+    // Пешком или трамваем - решает не только сама пара: после первой поездки каждая посадка стоит
+    // transferSeconds, как в графе поиска. cost[r] - лучшая цена префикса, r - была ли уже поездка.
+    const long long UNREACHED = LLONG_MAX / 2;
+    long long cost[2] = {0, UNREACHED};
+    std::vector<std::array<char, 2>> rode(hops.size()); // Участок i в состоянии r пройден трамваем
+    std::vector<std::array<char, 2>> cameFrom(hops.size()); // Состояние до участка i
+    for (size_t i = 0; i < hops.size(); ++i) {
+        long long next[2] = {UNREACHED, UNREACHED};
+        for (int r = 0; r < 2; ++r) {
+            if (cost[r] >= UNREACHED) continue;
+            if (hops[i].walkSeconds != INT_MAX && cost[r] + hops[i].walkSeconds < next[r]) {
+                next[r] = cost[r] + hops[i].walkSeconds;
+                rode[i][r] = 0;
+                cameFrom[i][r] = static_cast<char>(r);
+            }
+            if (hops[i].tram >= 0) {
+                long long ride = cost[r] + static_cast<long long>(hops[i].hops) * rideSeconds + (r ? transferSeconds : 0);
+                if (ride <= next[1]) {
+                    next[1] = ride;
+                    rode[i][1] = 1;
+                    cameFrom[i][1] = static_cast<char>(r);
+                }
+            }
+        }
+        cost[0] = next[0];
+        cost[1] = next[1];
+    }
+
+    std::vector<char> byTram(hops.size());
+    int state = cost[1] < cost[0] ? 1 : 0;
+    path.seconds = static_cast<int>(cost[state]);
+    for (size_t i = hops.size(); i-- > 0;) {
+        byTram[i] = rode[i][state];
+        state = cameFrom[i][state];
+    }
+
+    path.stops.push_back(pattern[0]);
+    for (size_t i = 0; i < hops.size(); ++i) {
+        size_t legStart = path.stops.size() - 1;
+        if (byTram[i]) {
+            int step = hops[i].to > hops[i].from ? 1 : -1;
+            for (int j = hops[i].from + step; j != hops[i].to + step; j += step) {
+                path.stops.push_back(network.tramStops[j]);
+            }
+            path.legs.push_back({hops[i].tram, legStart, path.stops.size() - 1});
+        } else {
+            path.stops.push_back(pattern[i + 1]);
+            path.legs.push_back({-1, legStart, path.stops.size() - 1});
+        }
+    }
+    return true;
+}
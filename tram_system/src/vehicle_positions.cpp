@@ -0,0 +1,63 @@
+#include "vehicle_positions.h"
+
+bool parseTimestamp(std::string_view text, uint32_t& timestamp) {
+    // Значение набирается в 64 битах, чтобы число больше UINT32_MAX отклонялось, а не заворачивалось
+    uint64_t value = 0;
+    for (char c : text) {
+        if (c < '0' || c > '9') {
+            return false;
+        }
+        value = value * 10 + static_cast<uint64_t>(c - '0');
+        if (value > UINT32_MAX) {
+            return false;
+        }
+    }
+    timestamp = static_cast<uint32_t>(value);
+    return !text.empty();
+}
+
+void VehiclePositions::addTram(const std::string& tramName) {
+    slots.try_emplace(tramName);
+}
+
+void VehiclePositions::removeTram(const std::string& tramName) {
+    slots.erase(tramName);
+}
+
+bool VehiclePositions::update(const std::string& tramName, uint32_t routeIndex, uint32_t timestamp) {
+    Slot* slot = find(tramName);
+    return slot && update(*slot, routeIndex, timestamp);
+}
+
+VehiclePositions::Slot* VehiclePositions::find(const std::string& tramName) {
+    auto it = slots.find(tramName);
+    return it == slots.end() ? nullptr : &it->second;
+}
+
+bool VehiclePositions::update(Slot& slot, uint32_t routeIndex, uint32_t timestamp) {
+    uint64_t desired = (static_cast<uint64_t>(timestamp) << 32) | (static_cast<uint64_t>(routeIndex) + 1);
+    uint64_t current = slot.state.load(std::memory_order_relaxed);
+    // Отметка времени в старших битах, поэтому более новое положение всегда больше по значению
+    while ((current >> 32) <= timestamp) {
+        if (slot.state.compare_exchange_weak(current, desired, std::memory_order_release, std::memory_order_relaxed)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+VehiclePosition VehiclePositions::get(const std::string& tramName) const {
+    VehiclePosition position;
+    auto it = slots.find(tramName);
+    if (it == slots.end()) {
+        return position;
+    }
+
+    uint64_t state = it->second.state.load(std::memory_order_acquire);
+    if (state != 0) {
+        position.known = true;
+        position.routeIndex = static_cast<uint32_t>(state & 0xFFFFFFFFu) - 1;
+        position.timestamp = static_cast<uint32_t>(state >> 32);
+    }
+    return position;
+}
@@ -1,228 +1,1229 @@
 #include <iostream>
 #include <string>
 #include <vector>
-#include <map>
+#include <unordered_map>
 #include <algorithm>
 #include <iomanip>
 #include <sstream>
 #include <cctype>
+#include <cstdint>
+#include <string_view>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <shared_mutex>
+#include <thread>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
 
 using namespace std;
 
-// Конфигурация склада по варианту 2
-const int ZONES_COUNT = 10; //кол-во зон
-const int RACKS_COUNT = 3; // кол-во стелажей в зоне
-const int SECTIONS_COUNT = 1; //кол-во секций в стелаже
-const int SHELVES_COUNT = 5; //кол-во полок в секции
 const int MAX_ITEMS_PER_CELL = 10; //max кол-во товаров в одной ячейке
-const int TOTAL_CAPACITY = 1500; //вместимость склада
+const char* const WAL_PREFIX = "5_1"; // Журнал изменений склада в рабочем каталоге: 5_1_<зоны>x<стеллажи>x<секции>x<полки>.wal
 
-// Структура для хранения информации о ячейке
-struct Cell {
-    string address;
-    map<string, int> items; // товар -> количество
-    int totalItems = 0;
+// Количество десятичных цифр в номере от 1 до count
+constexpr int digitsFor(int count) {
+    int digits = 1;
+    while (count >= 10) {
+        count /= 10;
+        ++digits;
+    }
+    return digits;
+}
+
+// Число из width цифр адреса начиная с pos, -1 если там не цифры
+constexpr int parseAddressField(string_view address, int pos, int width) {
+    int value = 0;
+    for (int i = pos; i < pos + width; ++i) {
+        if (address[i] < '0' || address[i] > '9') return -1;
+        value = value * 10 + (address[i] - '0');
+    }
+    return value;
+}
+
+// Адрес ZRSP: буква зоны, затем номера стеллажа, секции и полки с нулями слева до ширины
+// самого большого номера (при 3 стеллажах, 1 секции и 5 полках это "A115").
+// Индекс ячейки считается арифметически; -1 если адрес неверен или выходит за склад.
+constexpr int decodeAddress(string_view address, int zones, int racks, int sections, int shelves) {
+    int rackWidth = digitsFor(racks), sectionWidth = digitsFor(sections), shelfWidth = digitsFor(shelves);
+    if (static_cast<int>(address.size()) != 1 + rackWidth + sectionWidth + shelfWidth) return -1;
+
+    int zone = address[0] - 'A';
+    int rack = parseAddressField(address, 1, rackWidth);
+    int section = parseAddressField(address, 1 + rackWidth, sectionWidth);
+    int shelf = parseAddressField(address, 1 + rackWidth + sectionWidth, shelfWidth);
+    if (zone < 0 || zone >= zones || rack < 1 || rack > racks ||
+        section < 1 || section > sections || shelf < 1 || shelf > shelves) {
+        return -1;
+    }
+    return ((zone * racks + rack - 1) * sections + section - 1) * shelves + shelf - 1;
+}
+
+// Обратное преобразование индекса ячейки в адрес
+string encodeAddress(int index, int racks, int sections, int shelves) {
+    int shelf = index % shelves + 1;
+    index /= shelves;
+    int section = index % sections + 1;
+    index /= sections;
+    int rack = index % racks + 1;
+    int zone = index / racks;
+
+    stringstream address;
+    address << static_cast<char>('A' + zone) << setfill('0')
+            << setw(digitsFor(racks)) << rack
+            << setw(digitsFor(sections)) << section
+            << setw(digitsFor(shelves)) << shelf;
+    return address.str();
+}
+
+// Конфигурация склада, заданная при компиляции: размеры подставляются в декодирование адреса как константы
+template <int Zones, int Racks, int Sections, int Shelves>
+struct StaticLayout {
+    static_assert(Zones >= 1 && Zones <= 26, "Зоны обозначаются буквами A-Z");
+    static_assert(Racks >= 1 && Sections >= 1 && Shelves >= 1, "Размеры склада должны быть положительными");
+
+    static constexpr int zones() { return Zones; }
+    static constexpr int racks() { return Racks; }
+    static constexpr int sections() { return Sections; }
+    static constexpr int shelves() { return Shelves; }
+    static constexpr int cellsPerZone() { return Racks * Sections * Shelves; }
+    static constexpr int cellCount() { return Zones * cellsPerZone(); }
+    static constexpr int addressLength() { return 1 + digitsFor(Racks) + digitsFor(Sections) + digitsFor(Shelves); }
+
+    static constexpr int cellIndex(string_view address) {
+        return decodeAddress(address, Zones, Racks, Sections, Shelves);
+    }
+    static string cellAddress(int index) {
+        return encodeAddress(index, Racks, Sections, Shelves);
+    }
+};
+
+// Конфигурация склада, заданная при запуске (для площадок другого размера без пересборки)
+struct RuntimeLayout {
+    int zoneCount, rackCount, sectionCount, shelfCount;
+
+    int zones() const { return zoneCount; }
+    int racks() const { return rackCount; }
+    int sections() const { return sectionCount; }
+    int shelves() const { return shelfCount; }
+    int cellsPerZone() const { return rackCount * sectionCount * shelfCount; }
+    int cellCount() const { return zoneCount * cellsPerZone(); }
+    int addressLength() const { return 1 + digitsFor(rackCount) + digitsFor(sectionCount) + digitsFor(shelfCount); }
+
+    int cellIndex(string_view address) const {
+        return decodeAddress(address, zoneCount, rackCount, sectionCount, shelfCount);
+    }
+    string cellAddress(int index) const {
+        return encodeAddress(index, rackCount, sectionCount, shelfCount);
+    }
+};
+
+// Конфигурация склада по варианту 2: 10 зон, 3 стеллажа в зоне, 1 секция в стеллаже, 5 полок в секции
+using Variant2Layout = StaticLayout<10, 3, 1, 5>;
+static_assert(Variant2Layout::cellIndex("A115") == 4 && Variant2Layout::cellIndex("J315") == 149,
+              "Адреса варианта 2 должны раскладываться без поиска");
+
+// Словарь товаров: каждое название хранится один раз, ячейки ссылаются на товар по ID.
+// Названия разложены по сегментам со своими блокировками, чтобы терминалы с разными товарами
+// не ждали друг друга; ID = номер в сегменте * SHARDS + номер сегмента
+class ItemDictionary {
+private:
+    static const int SHARDS = 16;
+    struct alignas(64) Shard {
+        mutable shared_mutex lock;
+        deque<string> names; // Название по номеру в сегменте; deque не перемещает строки при росте
+        unordered_map<string, int> ids; // ID по названию
+    };
+    array<Shard, SHARDS> shards;
+
+    static int shardOf(const string& name) {
+        return static_cast<int>(hash<string>()(name) % SHARDS);
+    }
+
+public:
+    // ID товара; новый товар получает следующий ID своего сегмента
+    int intern(const string& name) {
+        int index = shardOf(name);
+        Shard& shard = shards[index];
+        {
+            shared_lock<shared_mutex> lock(shard.lock);
+            auto it = shard.ids.find(name);
+            if (it != shard.ids.end()) return it->second;
+        }
+        unique_lock<shared_mutex> lock(shard.lock);
+        auto [it, inserted] = shard.ids.emplace(name, static_cast<int>(shard.names.size()) * SHARDS + index);
+        if (inserted) {
+            shard.names.push_back(name);
+        }
+        return it->second;
+    }
+
+    // ID товара или -1, если такого товара еще не было
+    int find(const string& name) const {
+        const Shard& shard = shards[shardOf(name)];
+        shared_lock<shared_mutex> lock(shard.lock);
+        auto it = shard.ids.find(name);
+        return it == shard.ids.end() ? -1 : it->second;
+    }
+
+    const string& name(int id) const {
+        const Shard& shard = shards[id % SHARDS];
+        shared_lock<shared_mutex> lock(shard.lock);
+        return shard.names[id / SHARDS];
+    }
 };
 
-// Класс для управления складом
+// Примененное изменение ячейки: для отката транзакции и записи в журнал на диске
+struct Move {
+    bool add; // true - добавление, false - удаление
+    int itemId;
+    int quantity;
+    int cell;
+};
+
+// Класс для управления складом; Layout - StaticLayout или RuntimeLayout.
+// Методы можно вызывать из нескольких потоков: изменение ячейки блокирует только ее зону,
+// итоги хранятся в атомарных счетчиках, INFO и WHERE копируют зоны по одной под их блокировкой
+template <typename Layout>
 class Warehouse {
 private:
-    vector<Cell> cells; 
-    int totalItemsInWarehouse = 0; //общее кол-во тавара на складе
-
-    // Генерация всех возможных адресов ячеек
-    void generateCells() {
-        const char zoneLetters[ZONES_COUNT] = {'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H', 'I', 'J'};
-        
-        for (char zone : zoneLetters) {
-            for (int rack = 1; rack <= RACKS_COUNT; ++rack) {
-                for (int section = 1; section <= SECTIONS_COUNT; ++section) {
-                    for (int shelf = 1; shelf <= SHELVES_COUNT; ++shelf) {
-                        stringstream address;
-                        address << zone << rack << section << shelf;
-                        cells.push_back({address.str()});
-                    }
-                }
-            }
+    // Все, что меняется вместе с ячейками зоны, защищено блокировкой зоны. Итоги пишутся только
+    // под ней, а читаются и без нее. Зоны выровнены по кэш-линии, чтобы потоки в разных зонах
+    // не делили одну линию
+    struct alignas(64) ZoneState {
+        mutex lock;
+        atomic<int> total{0}; // Единиц в зоне
+        atomic<int> emptyCells{0}; // Пустых ячеек в зоне
+        unique_ptr<atomic<int>[]> rackTotals; // Единиц на стеллаже зоны
+        vector<vector<int>> itemCells; // Обратный индекс зоны: ячейки, где лежит товар, по ID товара
+        vector<int> itemTotals; // Единиц товара в зоне по ID товара
+        // Индекс свободного места: ячейки зоны разложены по корзинам с одинаковым свободным местом
+        vector<vector<int>> freeBuckets; // Корзина по количеству свободных единиц
+    };
+
+    Layout layout;
+    ItemDictionary itemNames;
+    // Ячейки хранятся столбцами по индексам Layout::cellIndex. В ячейке не больше MAX_ITEMS_PER_CELL
+    // единиц, значит и разных товаров не больше, поэтому у каждой ячейки фиксированный набор слотов;
+    // занятые слоты идут подряд с начала. Ячейка меняется только под блокировкой своей зоны
+    vector<int> cellTotals; // Количество единиц в ячейке
+    vector<int> cellSlotCounts; // Занятых слотов в ячейке
+    vector<int> slotItems; // ID товара в слоте, слоты ячейки i начинаются с i * MAX_ITEMS_PER_CELL
+    vector<int> slotQuantities; // Количество товара в слоте
+    vector<int> slotListPositions; // Позиция ячейки слота в itemCells ее зоны
+    vector<int> cellBucketPositions; // Позиция ячейки в ее корзине свободного места
+    unique_ptr<ZoneState[]> zoneStates;
+
+    // Изменение счетчика его единственным писателем (под блокировкой зоны): без атомарного
+    // чтения-изменения-записи, читатели видят либо старое, либо новое значение
+    static void addTo(atomic<int>& counter, int delta) {
+        counter.store(counter.load(memory_order_relaxed) + delta, memory_order_relaxed);
+    }
+
+    int zoneOf(int cell) const {
+        return cell / layout.cellsPerZone();
+    }
+
+    // Зоны этого склада, заблокированные текущим потоком через ZoneLocks
+    uint32_t heldZones() const;
+
+    // Блокировка зоны; зону, уже заблокированную потоком через ZoneLocks, повторно не берет
+    unique_lock<mutex> lockZone(int zone) const {
+        if (heldZones() & (1u << zone)) return unique_lock<mutex>();
+        return unique_lock<mutex>(zoneStates[zone].lock);
+    }
+
+    double zoneLoadPercent(int units) const { // Загруженность зоны с units единицами в процентах
+        return (static_cast<double>(units) / (layout.cellsPerZone() * MAX_ITEMS_PER_CELL)) * 100;
+    }
+
+    int getTotalItems() const { // Всего единиц на складе
+        int total = 0;
+        for (int zone = 0; zone < layout.zones(); ++zone) {
+            total += zoneStates[zone].total.load(memory_order_relaxed);
+        }
+        return total;
+    }
+
+    // Изменение количества в ячейке вместе со всеми итогами
+    void changeCellTotal(int cell, int delta) {
+        int cellsPerRack = layout.sections() * layout.shelves();
+        int zone = zoneOf(cell);
+        ZoneState& state = zoneStates[zone];
+
+        // Перенос ячейки в корзину с новым свободным местом: на ее место встает последняя ячейка корзины
+        vector<int>& from = state.freeBuckets[MAX_ITEMS_PER_CELL - cellTotals[cell]];
+        int position = cellBucketPositions[cell];
+        from[position] = from.back();
+        cellBucketPositions[from[position]] = position;
+        from.pop_back();
+        vector<int>& to = state.freeBuckets[MAX_ITEMS_PER_CELL - cellTotals[cell] - delta];
+        cellBucketPositions[cell] = static_cast<int>(to.size());
+        to.push_back(cell);
+
+        int emptied = (cellTotals[cell] + delta == 0) - (cellTotals[cell] == 0);
+        if (emptied != 0) addTo(state.emptyCells, emptied);
+        cellTotals[cell] += delta;
+        addTo(state.total, delta);
+        addTo(state.rackTotals[cell / cellsPerRack - zone * layout.racks()], delta);
+    }
+
+    // Добавление в ячейку без проверок: место в ячейке уже проверено, зона заблокирована
+    void putIntoCell(int cell, int itemId, int quantity, vector<Move>* journal) {
+        ZoneState& state = zoneStates[zoneOf(cell)];
+        if (itemId >= static_cast<int>(state.itemCells.size())) {
+            state.itemCells.resize(itemId + 1);
+            state.itemTotals.resize(itemId + 1, 0);
+        }
+
+        int slot = findSlot(cell, itemId);
+        if (slot < 0) {
+            slot = cell * MAX_ITEMS_PER_CELL + cellSlotCounts[cell]++;
+            slotItems[slot] = itemId;
+            slotListPositions[slot] = static_cast<int>(state.itemCells[itemId].size());
+            state.itemCells[itemId].push_back(cell);
         }
+        slotQuantities[slot] += quantity;
+        state.itemTotals[itemId] += quantity;
+        changeCellTotal(cell, quantity);
+        if (journal) journal->push_back({true, itemId, quantity, cell});
     }
 
-    // Поиск ячейки по адресу
-    Cell* findCell(const string& address) {
-        for (auto& cell : cells) {
-            if (cell.address == address) {
-                return &cell;
+    // Удаление из ячейки без проверок: товара в ячейке уже достаточно, зона заблокирована
+    void takeFromCell(int cell, int itemId, int quantity, vector<Move>* journal) {
+        ZoneState& state = zoneStates[zoneOf(cell)];
+        int slot = findSlot(cell, itemId);
+        slotQuantities[slot] -= quantity;
+        state.itemTotals[itemId] -= quantity;
+        changeCellTotal(cell, -quantity);
+
+        if (slotQuantities[slot] == 0) {
+            // Ячейка уходит из обратного индекса: на ее место встает последняя ячейка списка товара
+            vector<int>& cellsOfItem = state.itemCells[itemId];
+            int position = slotListPositions[slot];
+            cellsOfItem[position] = cellsOfItem.back();
+            cellsOfItem.pop_back();
+            if (position < static_cast<int>(cellsOfItem.size())) {
+                slotListPositions[findSlot(cellsOfItem[position], itemId)] = position;
             }
+
+            // Опустевший слот занимает последний занятый слот ячейки
+            int last = cell * MAX_ITEMS_PER_CELL + --cellSlotCounts[cell];
+            slotItems[slot] = slotItems[last];
+            slotQuantities[slot] = slotQuantities[last];
+            slotListPositions[slot] = slotListPositions[last];
+            slotItems[last] = -1;
+            slotQuantities[last] = 0;
+            slotListPositions[last] = -1;
         }
-        return nullptr;
+        if (journal) journal->push_back({false, itemId, quantity, cell});
+    }
+
+    // Ячейка зоны с наименьшим свободным местом не меньше need, а если такой нет - с наибольшим.
+    // Корзин MAX_ITEMS_PER_CELL + 1, поэтому выбор не зависит от числа ячеек; -1 если зона заполнена
+    int takeFreeCell(int zone, int need) const {
+        const vector<vector<int>>& buckets = zoneStates[zone].freeBuckets;
+        for (int freeUnits = need; freeUnits <= MAX_ITEMS_PER_CELL; ++freeUnits) {
+            if (!buckets[freeUnits].empty()) return buckets[freeUnits].back();
+        }
+        for (int freeUnits = need - 1; freeUnits >= 1; --freeUnits) {
+            if (!buckets[freeUnits].empty()) return buckets[freeUnits].back();
+        }
+        return -1;
+    }
+
+    // Слот товара в ячейке или -1
+    int findSlot(int cell, int itemId) const {
+        int begin = cell * MAX_ITEMS_PER_CELL;
+        for (int slot = begin; slot < begin + cellSlotCounts[cell]; ++slot) {
+            if (slotItems[slot] == itemId) return slot;
+        }
+        return -1;
     }
 
 public:
-    Warehouse() {
-        generateCells();
+    // Блокировка набора зон (бит на зону, зон не больше 26) в порядке индексов, чтобы потоки
+    // с пересекающимися наборами не заблокировали друг друга. Нужна операциям, которые охватывают
+    // несколько зон или должны идти подряд без чужих изменений в своих зонах. Зоны, уже
+    // заблокированные потоком, пропускаются; вложенный набор не должен добавлять новые зоны
+    // к уже заблокированным, иначе нарушится порядок захвата
+    class ZoneLocks {
+    private:
+        const Warehouse& warehouse;
+        uint32_t zones; // Зоны, заблокированные этим объектом
+        const ZoneLocks* outer; // Блокировки, взятые потоком раньше
+
+        friend class Warehouse;
+
+    public:
+        ZoneLocks(const Warehouse& warehouse, uint32_t zones)
+            : warehouse(warehouse), zones(zones & ~warehouse.heldZones()), outer(heldLocks) {
+            for (int zone = 0; zone < warehouse.layout.zones(); ++zone) {
+                if (this->zones & (1u << zone)) warehouse.zoneStates[zone].lock.lock();
+            }
+            heldLocks = this;
+        }
+        ~ZoneLocks() {
+            heldLocks = outer;
+            for (int zone = warehouse.layout.zones() - 1; zone >= 0; --zone) {
+                if (zones & (1u << zone)) warehouse.zoneStates[zone].lock.unlock();
+            }
+        }
+        ZoneLocks(const ZoneLocks&) = delete;
+        ZoneLocks& operator=(const ZoneLocks&) = delete;
+    };
+
+    uint32_t allZones() const { // Набор из всех зон склада
+        return (1u << layout.zones()) - 1;
     }
 
-    // Добавление товара в ячейку
-    bool addItem(const string& itemName, int quantity, const string& address) {
+    // Зона ячейки с адресом в виде набора; пустой набор, если адрес неверен
+    uint32_t zoneOfAddress(const string& address) const {
+        int cell = layout.cellIndex(address);
+        return cell < 0 ? 0 : 1u << zoneOf(cell);
+    }
+
+    explicit Warehouse(const Layout& layout = Layout())
+        : layout(layout),
+          cellTotals(layout.cellCount(), 0),
+          cellSlotCounts(layout.cellCount(), 0),
+          slotItems(static_cast<size_t>(layout.cellCount()) * MAX_ITEMS_PER_CELL, -1),
+          slotQuantities(static_cast<size_t>(layout.cellCount()) * MAX_ITEMS_PER_CELL, 0),
+          slotListPositions(static_cast<size_t>(layout.cellCount()) * MAX_ITEMS_PER_CELL, -1),
+          cellBucketPositions(layout.cellCount()),
+          zoneStates(new ZoneState[layout.zones()]) {
+        for (int zone = 0; zone < layout.zones(); ++zone) {
+            ZoneState& state = zoneStates[zone];
+            state.emptyCells.store(layout.cellsPerZone(), memory_order_relaxed);
+            state.rackTotals.reset(new atomic<int>[layout.racks()]());
+            state.freeBuckets.resize(MAX_ITEMS_PER_CELL + 1);
+            vector<int>& bucket = state.freeBuckets[MAX_ITEMS_PER_CELL];
+            for (int cell = zone * layout.cellsPerZone(); cell < (zone + 1) * layout.cellsPerZone(); ++cell) {
+                cellBucketPositions[cell] = static_cast<int>(bucket.size());
+                bucket.push_back(cell);
+            }
+        }
+    }
+
+    const Layout& getLayout() const {
+        return layout;
+    }
+
+    int getCapacity() const { // Вместимость склада
+        return layout.cellCount() * MAX_ITEMS_PER_CELL;
+    }
+
+    // Добавление товара в ячейку; примененное изменение дописывается в journal, если он задан
+    bool addItem(const string& itemName, int quantity, const string& address, ostream& out, vector<Move>* journal = nullptr) {
         //Поиск ячейки по адресу
-        Cell* cell = findCell(address);
-        if (!cell) {
-            cout << "Ошибка: Ячейка с адресом " << address << " не найдена." << endl;
+        int cell = layout.cellIndex(address);
+        if (cell < 0) {
+            out << "Ошибка: Ячейка с адресом " << address << " не найдена." << endl;
             return false;
         }
+
+        int current = 0;
+        {
+            unique_lock<mutex> lock = lockZone(zoneOf(cell));
+            current = cellTotals[cell];
+            if (current + quantity <= MAX_ITEMS_PER_CELL) {
+                putIntoCell(cell, itemNames.intern(itemName), quantity, journal);
+                return true;
+            }
+        }
         // проверка на заполненость ячейки
-        if (cell->totalItems + quantity > MAX_ITEMS_PER_CELL) {
-            cout << "Ошибка: Превышена вместимость ячейки " << address 
-                 << " (текущее количество: " << cell->totalItems 
-                 << ", пытаетесь добавить: " << quantity 
-                 << ", максимум: " << MAX_ITEMS_PER_CELL << ")." << endl;
-            return false;
+        out << "Ошибка: Превышена вместимость ячейки " << address
+            << " (текущее количество: " << current
+            << ", пытаетесь добавить: " << quantity
+            << ", максимум: " << MAX_ITEMS_PER_CELL << ")." << endl;
+        return false;
+    }
+
+    // Размещение товара без адреса: сначала досыпается в ячейки, где товар уже лежит,
+    // затем в наименее загруженные зоны, в зоне - в ячейку с наименьшим подходящим свободным местом.
+    // Количество делится между ячейками; если места на складе не хватает, ничего не размещается.
+    // Размещение охватывает несколько зон, поэтому идет под блокировкой всех зон
+    bool placeItem(const string& itemName, int quantity, ostream& out, vector<Move>* journal = nullptr) {
+        vector<pair<int, int>> placed; // Ячейка и количество
+        {
+            ZoneLocks locks(*this, allZones());
+            int freeSpace = getCapacity() - getTotalItems();
+            if (quantity > freeSpace) {
+                out << "Ошибка: Недостаточно места на складе (свободно: " << freeSpace
+                    << ", пытаетесь добавить: " << quantity << ")." << endl;
+                return false;
+            }
+
+            int itemId = itemNames.intern(itemName);
+            int remaining = quantity;
+
+            vector<int> holding;
+            for (int zone = 0; zone < layout.zones(); ++zone) {
+                const ZoneState& state = zoneStates[zone];
+                if (itemId < static_cast<int>(state.itemCells.size())) {
+                    holding.insert(holding.end(), state.itemCells[itemId].begin(), state.itemCells[itemId].end());
+                }
+            }
+            sort(holding.begin(), holding.end(), [this](int a, int b) {
+                return cellTotals[a] != cellTotals[b] ? cellTotals[a] < cellTotals[b] : a < b;
+            });
+            for (int cell : holding) {
+                int amount = min(remaining, MAX_ITEMS_PER_CELL - cellTotals[cell]);
+                if (amount <= 0) continue;
+                putIntoCell(cell, itemId, amount, journal);
+                placed.emplace_back(cell, amount);
+                remaining -= amount;
+                if (remaining == 0) break;
+            }
+
+            vector<int> zones(layout.zones());
+            for (int zone = 0; zone < layout.zones(); ++zone) zones[zone] = zone;
+            sort(zones.begin(), zones.end(), [this](int a, int b) {
+                int totalA = zoneStates[a].total.load(memory_order_relaxed);
+                int totalB = zoneStates[b].total.load(memory_order_relaxed);
+                return totalA != totalB ? totalA < totalB : a < b;
+            });
+            for (int zone : zones) {
+                while (remaining > 0) {
+                    int cell = takeFreeCell(zone, min(remaining, MAX_ITEMS_PER_CELL));
+                    if (cell < 0) break;
+                    int amount = min(remaining, MAX_ITEMS_PER_CELL - cellTotals[cell]);
+                    putIntoCell(cell, itemId, amount, journal);
+                    placed.emplace_back(cell, amount);
+                    remaining -= amount;
+                }
+                if (remaining == 0) break;
+            }
+        }
+
+        out << "Товар " << itemName << " размещен: ";
+        for (const auto& [cell, amount] : placed) {
+            out << layout.cellAddress(cell) << " - " << amount << ", ";
         }
-        
-        cell->items[itemName] += quantity;
-        cell->totalItems += quantity;
-        totalItemsInWarehouse += quantity;
+        out << endl;
         return true;
     }
 
-    // Удаление товара из ячейки
-    bool removeItem(const string& itemName, int quantity, const string& address) {
-        Cell* cell = findCell(address);
-        if (!cell) {
-            cout << "Ошибка: Ячейка с адресом " << address << " не найдена." << endl;
+    // Удаление товара из ячейки; примененное изменение дописывается в journal, если он задан
+    bool removeItem(const string& itemName, int quantity, const string& address, ostream& out, vector<Move>* journal = nullptr) {
+        int cell = layout.cellIndex(address);
+        if (cell < 0) {
+            out << "Ошибка: Ячейка с адресом " << address << " не найдена." << endl;
             return false;
         }
 
-        if (cell->items.find(itemName) == cell->items.end() || cell->items[itemName] < quantity) {
-            cout << "Ошибка: Недостаточно товара " << itemName << " в ячейке " << address 
-                 << " (текущее количество: " << (cell->items.count(itemName) ? cell->items[itemName] : 0) 
-                 << ", пытаетесь удалить: " << quantity << ")." << endl;
-            return false;
+        int itemId = itemNames.find(itemName);
+        int current = 0;
+        {
+            unique_lock<mutex> lock = lockZone(zoneOf(cell));
+            int slot = itemId < 0 ? -1 : findSlot(cell, itemId);
+            current = slot < 0 ? 0 : slotQuantities[slot];
+            if (slot >= 0 && current >= quantity) {
+                takeFromCell(cell, itemId, quantity, journal);
+                return true;
+            }
         }
-        
-        cell->items[itemName] -= quantity;
-        cell->totalItems -= quantity;
-        totalItemsInWarehouse -= quantity;
+        out << "Ошибка: Недостаточно товара " << itemName << " в ячейке " << address
+            << " (текущее количество: " << current
+            << ", пытаетесь удалить: " << quantity << ")." << endl;
+        return false;
+    }
+
+    const string& getItemName(int itemId) const {
+        return itemNames.name(itemId);
+    }
 
-        if (cell->items[itemName] == 0) {
-            cell->items.erase(itemName);
+    // Отмена изменений журнала в обратном порядке; журнал очищается
+    void rollback(vector<Move>& journal) {
+        while (!journal.empty()) {
+            Move move = journal.back();
+            journal.pop_back();
+            unique_lock<mutex> lock = lockZone(zoneOf(move.cell));
+            if (move.add) {
+                takeFromCell(move.cell, move.itemId, move.quantity, nullptr);
+            } else {
+                putIntoCell(move.cell, move.itemId, move.quantity, nullptr);
+            }
         }
+    }
 
+    // Повтор изменения из журнала на диске без вывода; false, если оно не подходит к складу
+    bool replayMove(bool add, const string& itemName, int quantity, const string& address, vector<Move>& journal) {
+        int cell = layout.cellIndex(address);
+        if (cell < 0 || quantity <= 0) return false;
+        unique_lock<mutex> lock = lockZone(zoneOf(cell));
+        if (add) {
+            if (cellTotals[cell] + quantity > MAX_ITEMS_PER_CELL) return false;
+            putIntoCell(cell, itemNames.intern(itemName), quantity, &journal);
+        } else {
+            int itemId = itemNames.find(itemName);
+            int slot = itemId < 0 ? -1 : findSlot(cell, itemId);
+            if (slot < 0 || slotQuantities[slot] < quantity) return false;
+            takeFromCell(cell, itemId, quantity, &journal);
+        }
         return true;
     }
 
-    // Получение информации о складе
-    void printInfo() const {
+    // Ячейки, в которых лежит товар, по обратному индексу. Зоны копируются по одной
+    // под их блокировкой, остальные зоны в это время можно менять
+    void printWhere(const string& itemName, ostream& out) const {
+        int itemId = itemNames.find(itemName);
+        vector<pair<int, int>> cells; // Ячейка и количество
+        int total = 0;
+        for (int zone = 0; itemId >= 0 && zone < layout.zones(); ++zone) {
+            unique_lock<mutex> lock = lockZone(zone);
+            const ZoneState& state = zoneStates[zone];
+            if (itemId >= static_cast<int>(state.itemCells.size())) continue;
+            for (int cell : state.itemCells[itemId]) {
+                cells.emplace_back(cell, slotQuantities[findSlot(cell, itemId)]);
+            }
+            total += state.itemTotals[itemId];
+        }
+        if (total == 0) {
+            out << "Товар " << itemName << " на складе отсутствует." << endl;
+            return;
+        }
+
+        sort(cells.begin(), cells.end());
+        out << "Товар " << itemName << " (всего " << total << "): ";
+        for (const auto& [cell, quantity] : cells) {
+            out << layout.cellAddress(cell) << " - " << quantity << ", ";
+        }
+        out << endl;
+    }
+
+    // Сводка загрузки по готовым итогам, без обращения к ячейкам и без блокировок:
+    // O(зон), для зоны - O(стеллажей)
+    void printLoad(const string& zoneName, ostream& out) const {
+        if (!zoneName.empty()) {
+            int zone = zoneName[0] - 'A';
+            if (zoneName.size() != 1 || zone < 0 || zone >= layout.zones()) {
+                out << "Ошибка: Зона " << zoneName << " не найдена." << endl;
+                return;
+            }
+            const ZoneState& state = zoneStates[zone];
+            int zoneTotal = state.total.load(memory_order_relaxed);
+            out << "Зона " << zoneName << ": " << fixed << setprecision(2) << zoneLoadPercent(zoneTotal) << "% (" << zoneTotal << ")" << endl;
+            int rackCapacity = layout.sections() * layout.shelves() * MAX_ITEMS_PER_CELL;
+            for (int rack = 0; rack < layout.racks(); ++rack) {
+                int items = state.rackTotals[rack].load(memory_order_relaxed);
+                out << "Стеллаж " << rack + 1 << ": " << fixed << setprecision(2)
+                    << (static_cast<double>(items) / rackCapacity) * 100 << "% (" << items << ")" << endl;
+            }
+            return;
+        }
+
+        vector<int> zoneTotals(layout.zones());
+        int totalItems = 0, emptyCells = 0;
+        for (int zone = 0; zone < layout.zones(); ++zone) {
+            zoneTotals[zone] = zoneStates[zone].total.load(memory_order_relaxed);
+            totalItems += zoneTotals[zone];
+            emptyCells += zoneStates[zone].emptyCells.load(memory_order_relaxed);
+        }
+        out << "Общая загруженность склада: " << fixed << setprecision(2)
+            << (static_cast<double>(totalItems) / getCapacity()) * 100 << "% ("
+            << totalItems << " из " << getCapacity() << ")" << endl;
+        out << "Пустых ячеек: " << emptyCells << " из " << layout.cellCount() << endl;
+        for (int zone = 0; zone < layout.zones(); ++zone) {
+            out << "Зона " << static_cast<char>('A' + zone) << ": " << fixed << setprecision(2) << zoneLoadPercent(zoneTotals[zone])
+                << "% (" << zoneTotals[zone] << ")" << endl;
+        }
+    }
+
+    // Получение информации о складе. Сначала зоны по одной копируются под их блокировкой
+    // (каждая зона согласована сама с собой), затем копия выводится без блокировок
+    void printInfo(ostream& out) const {
+        vector<int> zoneTotals(layout.zones());
+        vector<int> filledCells, emptyCells;
+        vector<pair<int, int>> filledSlots; // ID товара и количество, слоты ячеек filledCells подряд
+        vector<int> slotCounts;
+        for (int zone = 0; zone < layout.zones(); ++zone) {
+            unique_lock<mutex> lock = lockZone(zone);
+            zoneTotals[zone] = zoneStates[zone].total.load(memory_order_relaxed);
+            for (int cell = zone * layout.cellsPerZone(); cell < (zone + 1) * layout.cellsPerZone(); ++cell) {
+                if (cellTotals[cell] == 0) {
+                    emptyCells.push_back(cell);
+                    continue;
+                }
+                filledCells.push_back(cell);
+                slotCounts.push_back(cellSlotCounts[cell]);
+                for (int slot = cell * MAX_ITEMS_PER_CELL; slot < cell * MAX_ITEMS_PER_CELL + cellSlotCounts[cell]; ++slot) {
+                    filledSlots.emplace_back(slotItems[slot], slotQuantities[slot]);
+                }
+            }
+        }
+
         // Общая загруженность склада
-        double warehouseLoad = (static_cast<double>(totalItemsInWarehouse) / TOTAL_CAPACITY) * 100;
-        cout << "Общая загруженность склада: " << fixed << setprecision(2) << warehouseLoad << "%" << endl;
+        int totalItems = 0;
+        for (int zoneTotal : zoneTotals) totalItems += zoneTotal;
+        double warehouseLoad = (static_cast<double>(totalItems) / getCapacity()) * 100;
+        out << "Общая загруженность склада: " << fixed << setprecision(2) << warehouseLoad << "%" << endl;
 
         // Загруженность по зонам
-        map<char, int> zoneItems;
-        vector<string> emptyCells;
-
-        for (const auto& cell : cells) {
-            char zone = cell.address[0];
-            zoneItems[zone] += cell.totalItems;
+        out << "\nЗагруженность по зонам:" << endl;
+        for (int zone = 0; zone < layout.zones(); ++zone) {
+            out << "Зона " << static_cast<char>('A' + zone) << ": " << fixed << setprecision(2)
+                << zoneLoadPercent(zoneTotals[zone]) << "%" << endl;
+        }
 
-            if (cell.totalItems == 0) {
-                emptyCells.push_back(cell.address);
+        // Содержимое непустых ячеек, товары по алфавиту
+        out << "\nСодержимое ячеек:" << endl;
+        vector<pair<string, int>> cellItems;
+        size_t next = 0;
+        for (size_t i = 0; i < filledCells.size(); ++i) {
+            cellItems.clear();
+            int cellTotal = 0;
+            for (int slot = 0; slot < slotCounts[i]; ++slot, ++next) {
+                cellItems.emplace_back(itemNames.name(filledSlots[next].first), filledSlots[next].second);
+                cellTotal += filledSlots[next].second;
             }
+            sort(cellItems.begin(), cellItems.end());
+            out << "Ячейка " << layout.cellAddress(filledCells[i]) << " (всего " << cellTotal << "): ";
+            for (const auto& [item, quantity] : cellItems) {
+                out << item << " - " << quantity << ", ";
+            }
+            out << endl;
         }
 
-        cout << "\nЗагруженность по зонам:" << endl;
-        for (const auto& [zone, items] : zoneItems) {
-            double zoneLoad = (static_cast<double>(items) / 
-                             (cells.size() / ZONES_COUNT * MAX_ITEMS_PER_CELL)) * 100;
-            cout << "Зона " << zone << ": " << fixed << setprecision(2) << zoneLoad << "%" << endl;
+        // Пустые ячейки
+        out << "\nПустые ячейки (" << emptyCells.size() << "): ";
+        int printed = 0;
+        for (int cell : emptyCells) {
+            if (printed > 0 && printed % 10 == 0) out << endl;
+            out << layout.cellAddress(cell) << " ";
+            ++printed;
         }
+        out << endl;
+    }
+
+private:
+    inline static thread_local const ZoneLocks* heldLocks = nullptr; // Последние блокировки потока
+};
 
-        // Содержимое непустых ячеек
-        cout << "\nСодержимое ячеек:" << endl;
-        for (const auto& cell : cells) {
-            if (cell.totalItems > 0) {
-                cout << "Ячейка " << cell.address << " (всего " << cell.totalItems << "): ";
-                for (const auto& [item, quantity] : cell.items) {
-                    cout << item << " - " << quantity << ", ";
+template <typename Layout>
+uint32_t Warehouse<Layout>::heldZones() const {
+    uint32_t zones = 0;
+    for (const ZoneLocks* locks = heldLocks; locks; locks = locks->outer) {
+        if (&locks->warehouse == this) zones |= locks->zones;
+    }
+    return zones;
+}
+
+// Журнал предзаписи: зафиксированные изменения дописываются в конец файла группами строк
+// "ADD|REMOVE <товар> <количество> <адрес>", каждая группа закрывается строкой "COMMIT <n>".
+// Групповая фиксация: сеанс ставит свою группу в очередь под короткой блокировкой и ждет диска;
+// один из ждущих сеансов пишет всю очередь одним вызовом и одним fsync, и все группы этой
+// очереди становятся постоянными вместе. Транзакция из тысяч операций - тоже одна группа.
+class WriteAheadLog {
+private:
+    string path;
+    FILE* file = nullptr;
+    bool damaged = false; // Журнал не удалось привести к состоянию склада, дописывать в него нельзя
+
+    mutex queueMutex; // Короткая блокировка очереди групп
+    string queue; // Группы, еще не записанные в файл
+    uint64_t queuedGroups = 0; // Номер последней группы в очереди
+
+    mutex syncMutex;
+    condition_variable synced;
+    bool syncing = false; // Один из сеансов сейчас пишет очередь на диск
+    uint64_t durableGroups = 0; // Номер последней группы, сброшенной на диск
+    atomic<bool> failed{false}; // Запись не удалась: примененные изменения могут не попасть на диск
+    atomic<uint64_t> syncCount{0}; // Сколько раз очередь сбрасывалась на диск
+
+    // Перенос записей начиная с offset в файл <path>.rejected и обрезка журнала до offset:
+    // иначе новые группы легли бы после записи, на которой повтор останавливается, и пропали бы
+    bool quarantineTail(uintmax_t offset) {
+        ifstream in(path, ios::binary);
+        ofstream rejected(path + ".rejected", ios::binary | ios::app);
+        if (!in || !rejected || !in.seekg(static_cast<streamoff>(offset))) return false;
+        rejected << in.rdbuf();
+        rejected.flush();
+        in.close();
+        if (!rejected) return false;
+        error_code error;
+        filesystem::resize_file(path, offset, error);
+        return !error;
+    }
+
+    // Запись буфера в конец файла и сброс на диск
+    bool writeAndSync(const string& buffer) {
+        if (!file || fwrite(buffer.data(), 1, buffer.size(), file) != buffer.size() || fflush(file) != 0) {
+            return false;
+        }
+        ++syncCount;
+#ifdef _WIN32
+        return _commit(_fileno(file)) == 0;
+#else
+        return fsync(fileno(file)) == 0;
+#endif
+    }
+
+public:
+    explicit WriteAheadLog(const string& path) : path(path) {}
+    ~WriteAheadLog() {
+        if (file) fclose(file);
+    }
+    WriteAheadLog(const WriteAheadLog&) = delete;
+    WriteAheadLog& operator=(const WriteAheadLog&) = delete;
+
+    // Повтор всех зафиксированных групп. Недописанный хвост (сбой во время записи) отбрасывается
+    // и обрезается, чтобы новые группы не склеились с ним. Если группа не подходит к складу,
+    // она и все следующие переносятся в <path>.rejected. Возвращает число повторенных изменений.
+    template <typename Layout>
+    int replay(Warehouse<Layout>& warehouse) {
+        ifstream in(path);
+        if (!in) return 0;
+
+        int replayed = 0;
+        streamoff committedEnd = 0; // Конец последней целой группы
+        vector<string> group;
+        vector<Move> journal; // Изменения повторяемой группы
+        string line;
+        while (getline(in, line)) {
+            if (line.compare(0, 7, "COMMIT ") != 0) {
+                group.push_back(line);
+                continue;
+            }
+            if (atoi(line.c_str() + 7) != static_cast<int>(group.size())) break;
+
+            for (const string& record : group) {
+                istringstream iss(record);
+                string action, itemName, address;
+                int quantity = 0;
+                iss >> action >> itemName >> quantity >> address;
+                if ((action != "ADD" && action != "REMOVE") || !warehouse.replayMove(action == "ADD", itemName, quantity, address, journal)) {
+                    warehouse.rollback(journal);
+                    in.close();
+                    damaged = !quarantineTail(static_cast<uintmax_t>(committedEnd));
+                    cout << "Ошибка: Журнал " << path << " не соответствует складу, восстановление остановлено. ";
+                    if (damaged) {
+                        cout << "Не удалось отделить неприменимые записи, журнал не будет дополняться." << endl;
+                    } else {
+                        cout << "Неприменимые записи перенесены в " << path << ".rejected." << endl;
+                    }
+                    return replayed;
                 }
-                cout << endl;
             }
+            journal.clear();
+            replayed += static_cast<int>(group.size());
+            group.clear();
+            committedEnd = in.eof() ? static_cast<streamoff>(filesystem::file_size(path)) : static_cast<streamoff>(in.tellg());
         }
+        in.close();
 
-        // Пустые ячейки
-        cout << "\nПустые ячейки (" << emptyCells.size() << "): ";
-        for (size_t i = 0; i < emptyCells.size(); ++i) {
-            if (i > 0 && i % 10 == 0) cout << endl;
-            cout << emptyCells[i] << " ";
+        error_code error;
+        if (static_cast<uintmax_t>(committedEnd) < filesystem::file_size(path, error) && !error) {
+            filesystem::resize_file(path, static_cast<uintmax_t>(committedEnd), error);
+        }
+        return replayed;
+    }
+
+    const string& getPath() const {
+        return path;
+    }
+
+    bool open() { // Открытие на дозапись
+        if (damaged) return false;
+        file = fopen(path.c_str(), "ab");
+        return file != nullptr;
+    }
+
+    bool isFailed() const {
+        return failed.load();
+    }
+
+    uint64_t getSyncCount() const {
+        return syncCount.load();
+    }
+
+    // Постановка изменений в очередь одной группой; номер группы передается в waitDurable,
+    // 0 - изменений нет. Вызывается под блокировками зон этих изменений, поэтому для каждой
+    // зоны порядок групп в файле совпадает с порядком их применения
+    template <typename Layout>
+    uint64_t append(const Warehouse<Layout>& warehouse, const vector<Move>& moves) {
+        if (moves.empty()) return 0;
+
+        string group;
+        for (const Move& move : moves) {
+            group += move.add ? "ADD " : "REMOVE ";
+            group += warehouse.getItemName(move.itemId);
+            group += ' ';
+            group += to_string(move.quantity);
+            group += ' ';
+            group += warehouse.getLayout().cellAddress(move.cell);
+            group += '\n';
+        }
+        group += "COMMIT " + to_string(moves.size()) + "\n";
+
+        lock_guard<mutex> lock(queueMutex);
+        queue += group;
+        return ++queuedGroups;
+    }
+
+    // Ожидание, пока группа с номером ticket окажется на диске; false, если запись не удалась.
+    // Если на диск сейчас никто не пишет, очередь пишет этот сеанс, иначе он ждет, пока запись
+    // закончится, и при необходимости пишет то, что накопилось за это время
+    bool waitDurable(uint64_t ticket) {
+        unique_lock<mutex> lock(syncMutex);
+        while (durableGroups < ticket && !failed) {
+            if (syncing) {
+                synced.wait(lock);
+                continue;
+            }
+            syncing = true;
+            lock.unlock();
+
+            string buffer;
+            uint64_t lastGroup = 0;
+            {
+                lock_guard<mutex> queueLock(queueMutex);
+                buffer.swap(queue);
+                lastGroup = queuedGroups;
+            }
+            bool written = writeAndSync(buffer);
+
+            lock.lock();
+            syncing = false;
+            if (written) {
+                durableGroups = lastGroup;
+            } else {
+                failed = true;
+            }
+            synced.notify_all();
         }
-        cout << endl;
+        return durableGroups >= ticket;
     }
 };
 
-// Функция для обработки ввода пользователя
-void processCommand(Warehouse& warehouse) {
-    string command;
-    cout << "\nВведите команду (ADD, REMOVE, INFO, EXIT): ";
-    getline(cin, command);
+// Состояние сеанса терминала: открытая транзакция, журнал на диске и вывод ответов
+struct Session {
+    WriteAheadLog* wal = nullptr; // nullptr - изменения не сохраняются
+    ostream* out = &cout; // Куда выводятся ответы сеанса
+    bool inTransaction = false;
+    vector<string> pending; // Команды ADD/REMOVE открытой транзакции, выполняются при COMMIT
+    vector<Move> journal; // Примененные изменения фиксируемой группы
+};
+
+// Разбор и выполнение ADD/REMOVE; при checkOnly только проверка формата. false, если команда не выполнена
+template <typename Layout>
+bool executeMove(Warehouse<Layout>& warehouse, const string& command, bool checkOnly, ostream& out, vector<Move>* journal) {
+    istringstream iss(command);
+    string action, itemName, address;
+    int quantity = 0;
+
+    iss >> action >> itemName >> quantity >> address;
+
+    // ADD без адреса - автоматическое размещение
+    if (action == "ADD" && address.empty()) {
+        if (quantity <= 0) {
+            out << "Ошибка: Количество должно быть положительным числом." << endl;
+            return false;
+        }
+        return checkOnly || warehouse.placeItem(itemName, quantity, out, journal);
+    }
+
+    // Проверка адреса: длина задается конфигурацией, остальное проверяет Layout::cellIndex
+    if (static_cast<int>(address.size()) != warehouse.getLayout().addressLength()) {
+        out << "Ошибка: Неверный формат адреса. Должен быть в формате ZRSP(зона-стеллаж-секция-полка), например "
+            << warehouse.getLayout().cellAddress(0) << "." << endl;
+        return false;
+    }
+
+    // Проверка количества
+    if (quantity <= 0) {
+        out << "Ошибка: Количество должно быть положительным числом." << endl;
+        return false;
+    }
 
-    if (command.empty()) return;
+    if (checkOnly) {
+        return true;
+    }
+    if (action == "ADD") {
+        return warehouse.addItem(itemName, quantity, address, out, journal);
+    }
+    return warehouse.removeItem(itemName, quantity, address, out, journal);
+}
+
+// Зоны, которые затронет ADD/REMOVE (разбор как в executeMove): зона ячейки по адресу,
+// для размещения без адреса - все зоны
+template <typename Layout>
+uint32_t commandZones(const Warehouse<Layout>& warehouse, const string& command) {
+    istringstream iss(command);
+    string action, itemName, address;
+    int quantity = 0;
+    iss >> action >> itemName >> quantity >> address;
+    return address.empty() ? warehouse.allZones() : warehouse.zoneOfAddress(address);
+}
+
+// Выполнение ADD/REMOVE одной группой, все или ничего, и фиксация в журнале на диске.
+// Блокируются только зоны, которые затрагивают команды, и только на время применения и
+// постановки группы в очередь журнала: откат при ошибке не заденет чужих изменений, а сеансы
+// в других зонах идут параллельно. Ожидание диска - уже без блокировок зон.
+// false, если группа не применена; если применена, но не записана, - true с предупреждением
+template <typename Layout>
+bool commitCommands(Warehouse<Layout>& warehouse, Session& session, const vector<string>& commands, bool transaction) {
+    ostream& out = *session.out;
+    if (session.wal && session.wal->isFailed()) {
+        out << "Ошибка: Журнал " << session.wal->getPath() << " не записывается, изменения не принимаются." << endl;
+        return false;
+    }
+
+    uint32_t zones = 0;
+    for (const string& command : commands) zones |= commandZones(warehouse, command);
+    uint64_t ticket = 0;
+    {
+        typename Warehouse<Layout>::ZoneLocks locks(warehouse, zones);
+        for (size_t i = 0; i < commands.size(); ++i) {
+            if (!executeMove(warehouse, commands[i], false, out, &session.journal)) {
+                warehouse.rollback(session.journal);
+                if (transaction) {
+                    out << "Ошибка: Операция " << i + 1 << " (" << commands[i]
+                        << ") не выполнена, транзакция отменена целиком." << endl;
+                }
+                return false;
+            }
+        }
+        if (session.wal) ticket = session.wal->append(warehouse, session.journal);
+        session.journal.clear();
+    }
+
+    // Другие сеансы уже могли изменить те же ячейки, поэтому после сбоя записи изменения
+    // не откатываются: группа остается примененной, о чем и сообщается. Журнал перестает
+    // приниматься, а склад - меняться
+    if (session.wal && !session.wal->waitDurable(ticket)) {
+        out << "Внимание: Изменения применены, но журнал " << session.wal->getPath()
+            << " не записан, после перезапуска они пропадут. Дальнейшие изменения не принимаются." << endl;
+    }
+    return true;
+}
+
+// Функция для обработки команды сеанса; false - сеанс завершен командой EXIT
+template <typename Layout>
+bool processCommand(Warehouse<Layout>& warehouse, Session& session, string command);
+
+// Замер пропускной способности ADD/REMOVE: каждый поток - отдельный сеанс, команды проходят
+// processCommand и блокировки зон. Склад отдельный, пустой, той же конфигурации. Сеанс i работает
+// с зоной i (если сеансов больше, чем зон, зоны делятся) и делает пары ADD/REMOVE по одной единице
+// в случайные ячейки. При durable каждая команда фиксируется в журнале на диске (временный файл
+// <журнал склада>.bench, потом удаляется) и ждет диска, так что ускорение дает в основном групповая
+// фиксация. Без durable журнала нет и замер показывает только масштабирование блокировок зон.
+template <typename Layout>
+void runBenchmark(const Layout& layout, const string& walPath, int operationsPerSession, bool durable, ostream& out) {
+    static mutex benchmarkMutex; // Замеры из разных сеансов идут по одному
+    lock_guard<mutex> benchmarkLock(benchmarkMutex);
+
+    int pairs = max(1, operationsPerSession / 2); // Пар ADD/REMOVE на сеанс
+    vector<string> items;
+    for (int i = 0; i < 16; ++i) items.push_back("ITEM" + to_string(i));
+
+    string benchPath = walPath + ".bench";
+    out << "Замер ADD/REMOVE через сеансы " << (durable ? "с журналом на диске" : "без журнала") << ": " << 2 * pairs
+        << " операций на сеанс, ядер: " << thread::hardware_concurrency() << endl;
+    double baseline = 0;
+    for (int sessions = 1; sessions <= 8; sessions *= 2) {
+        Warehouse<Layout> warehouse(layout);
+        error_code error;
+        if (durable) filesystem::remove(benchPath, error);
+        double seconds = 0;
+        uint64_t syncs = 0;
+        {
+            WriteAheadLog wal(benchPath);
+            if (durable && !wal.open()) {
+                out << "Ошибка: Не удалось создать " << benchPath << "." << endl;
+                return;
+            }
+            vector<thread> workers;
+            auto start = chrono::steady_clock::now();
+            for (int worker = 0; worker < sessions; ++worker) {
+                workers.emplace_back([&, worker] {
+                    ostream discard(nullptr); // Ответы сеанса не нужны
+                    Session session;
+                    session.wal = durable ? &wal : nullptr;
+                    session.out = &discard;
+                    int zone = worker % layout.zones();
+                    minstd_rand random(worker + 1);
+                    for (int i = 0; i < pairs; ++i) {
+                        int cell = zone * layout.cellsPerZone() + static_cast<int>(random() % layout.cellsPerZone());
+                        string move = items[random() % items.size()] + " 1 " + layout.cellAddress(cell);
+                        processCommand(warehouse, session, "ADD " + move);
+                        processCommand(warehouse, session, "REMOVE " + move);
+                    }
+                });
+            }
+            for (thread& worker : workers) worker.join();
+            seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            syncs = wal.getSyncCount();
+            if (wal.isFailed()) {
+                out << "Ошибка: Не удалось записать " << benchPath << "." << endl;
+                return;
+            }
+        }
+        if (durable) filesystem::remove(benchPath, error);
+
+        double commits = 2.0 * pairs * sessions;
+        double throughput = commits / seconds;
+        if (baseline == 0) baseline = throughput;
+        out << "Сеансов: " << sessions << ", операций в секунду: " << fixed << setprecision(0) << throughput
+            << ", ускорение: " << setprecision(2) << throughput / baseline;
+        if (durable) out << ", фиксаций на синхронизацию: " << commits / max<uint64_t>(syncs, 1);
+        out << endl;
+    }
+}
+
+template <typename Layout>
+bool processCommand(Warehouse<Layout>& warehouse, Session& session, string command) {
+    if (command.empty()) return true;
+    ostream& out = *session.out;
 
     // Преобразование команды в верхний регистр
     transform(command.begin(), command.end(), command.begin(), ::toupper);
 
     if (command == "INFO") {
-        warehouse.printInfo();
+        warehouse.printInfo(out);
     }
-    else if (command == "EXIT") {
-        exit(0);
+    else if (command == "LOAD" || command.find("LOAD ") == 0) {
+        istringstream iss(command);
+        string action, zone;
+        iss >> action >> zone;
+        warehouse.printLoad(zone, out);
     }
-    else if (command.find("ADD ") == 0 || command.find("REMOVE ") == 0) {
+    else if (command.find("WHERE ") == 0) {
         istringstream iss(command);
-        string action, itemName, address;
-        int quantity;
-
-        iss >> action >> itemName >> quantity >> address;
-
-        // Проверка адреса
-        if (address.size() != 4) {
-            cout << "Ошибка: Неверный формат адреса. Должен быть в формате ZRSP(зона-стеллаж-секция-полка), например А1234." << endl;
-            return;
+        string action, itemName;
+        iss >> action >> itemName;
+        warehouse.printWhere(itemName, out);
+    }
+    else if (command == "BENCH" || command.find("BENCH ") == 0) {
+        // BENCH [MEMORY] [<операций на сеанс>]; MEMORY - без журнала, только блокировки зон
+        istringstream iss(command);
+        string action, mode, count;
+        iss >> action >> mode;
+        bool durable = mode != "MEMORY";
+        if (durable) {
+            count = mode;
+        } else {
+            iss >> count;
         }
-
-        // Проверка количества
-        if (quantity <= 0) {
-            cout << "Ошибка: Количество должно быть положительным числом." << endl;
-            return;
+        int operations = count.empty() ? (durable ? 2000 : 200000) : atoi(count.c_str());
+        if (operations <= 0) {
+            out << "Ошибка: Количество операций должно быть положительным числом." << endl;
+            return true;
+        }
+        runBenchmark(warehouse.getLayout(), session.wal ? session.wal->getPath() : string(WAL_PREFIX) + ".wal",
+                     operations, durable, out);
+    }
+    else if (command == "EXIT") {
+        return false;
+    }
+    else if (command == "BEGIN") {
+        if (session.inTransaction) {
+            out << "Ошибка: Транзакция уже открыта." << endl;
+            return true;
+        }
+        session.inTransaction = true;
+        session.pending.clear();
+        out << "Транзакция начата." << endl;
+    }
+    else if (command == "COMMIT" || command == "ROLLBACK") {
+        if (!session.inTransaction) {
+            out << "Ошибка: Нет открытой транзакции." << endl;
+            return true;
+        }
+        session.inTransaction = false;
+        if (command == "ROLLBACK") {
+            out << "Транзакция отменена (" << session.pending.size() << " операций)." << endl;
+            session.pending.clear();
+            return true;
         }
 
-        if (action == "ADD") {
-            warehouse.addItem(itemName, quantity, address);
+        if (commitCommands(warehouse, session, session.pending, true)) {
+            out << "Транзакция применена (" << session.pending.size() << " операций)." << endl;
         }
-        else if (action == "REMOVE") {
-            warehouse.removeItem(itemName, quantity, address);
+        session.pending.clear();
+    }
+    else if (command.find("ADD ") == 0 || command.find("REMOVE ") == 0) {
+        if (session.inTransaction) {
+            if (executeMove(warehouse, command, true, out, nullptr)) {
+                session.pending.push_back(command);
+                out << "Операция добавлена в транзакцию (всего " << session.pending.size() << ")." << endl;
+            }
+            return true;
         }
+        // Одиночное изменение тоже пишется в журнал на диске, поэтому фиксируется так же, как транзакция
+        commitCommands(warehouse, session, {command}, false);
     }
     else {
-        cout << "Ошибка: Неизвестная команда. Доступные команды: ADD, REMOVE, INFO, EXIT." << endl;
+        out << "Ошибка: Неизвестная команда. Доступные команды: ADD, REMOVE, WHERE, LOAD, INFO, BEGIN, COMMIT, ROLLBACK, BENCH, EXIT." << endl;
     }
+    return true;
 }
 
-int main() {
-    setlocale(LC_ALL, "Russian");
-
-    Warehouse warehouse;
+// Вывод конфигурации, восстановление из журнала и цикл обработки команд консоли
+template <typename Layout>
+int run(Warehouse<Layout>& warehouse) {
+    const Layout& layout = warehouse.getLayout();
     cout << "Программа учета товаров на складе" << endl;
     cout << "Конфигурация склада:" << endl;
-    cout << "- Зон хранения: " << ZONES_COUNT << endl;
-    cout << "- Стеллажей в зоне: " << RACKS_COUNT << endl;
-    cout << "- Секций в стеллаже: " << SECTIONS_COUNT << endl;
-    cout << "- Полок в секции: " << SHELVES_COUNT << endl;
+    cout << "- Зон хранения: " << layout.zones() << endl;
+    cout << "- Стеллажей в зоне: " << layout.racks() << endl;
+    cout << "- Секций в стеллаже: " << layout.sections() << endl;
+    cout << "- Полок в секции: " << layout.shelves() << endl;
     cout << "- Максимум в ячейке: " << MAX_ITEMS_PER_CELL << " единиц" << endl;
-    cout << "- Общая вместимость: " << TOTAL_CAPACITY << " единиц" << endl;
+    cout << "- Общая вместимость: " << warehouse.getCapacity() << " единиц" << endl;
 
-    while (true) {
-        processCommand(warehouse);
+    // Состояние восстанавливается из журнала, дальше каждое зафиксированное изменение дописывается в него
+    // У каждой конфигурации склада свой журнал: журнал другой конфигурации к ней не подходит
+    WriteAheadLog wal(string(WAL_PREFIX) + "_" + to_string(layout.zones()) + "x" + to_string(layout.racks()) + "x" +
+                      to_string(layout.sections()) + "x" + to_string(layout.shelves()) + ".wal");
+    int replayed = wal.replay(warehouse);
+    if (replayed > 0) {
+        cout << "Восстановлено из журнала " << wal.getPath() << ": " << replayed << " изменений" << endl;
+    }
+    Session session;
+    if (wal.open()) {
+        session.wal = &wal;
+    } else {
+        cout << "Внимание: Журнал " << wal.getPath() << " недоступен, изменения не будут сохранены." << endl;
     }
 
+    string command;
+    do {
+        cout << "\nВведите команду (ADD, REMOVE, WHERE, LOAD, INFO, BEGIN, COMMIT, ROLLBACK, BENCH, EXIT): ";
+        if (!getline(cin, command)) return 0;
+    } while (processCommand(warehouse, session, command));
     return 0;
-}
\ No newline at end of file
+}
+
+// Без аргументов используется вариант 2, иначе размеры задаются при запуске:
+// 5_1 <зоны> <стеллажи> <секции> <полки>
+int main(int argc, char* argv[]) {
+    setlocale(LC_ALL, "Russian");
+
+    if (argc == 5) {
+        RuntimeLayout layout{atoi(argv[1]), atoi(argv[2]), atoi(argv[3]), atoi(argv[4])};
+        if (layout.zoneCount < 1 || layout.zoneCount > 26 || layout.rackCount < 1 ||
+            layout.sectionCount < 1 || layout.shelfCount < 1) {
+            cout << "Ошибка: Неверная конфигурация склада (зон от 1 до 26, остальные размеры положительные)." << endl;
+            return 1;
+        }
+        Warehouse<RuntimeLayout> warehouse(layout);
+        return run(warehouse);
+    }
+
+    Warehouse<Variant2Layout> warehouse;
+    return run(warehouse);
+}